@@ -1,3 +1,7 @@
 #include "paintdevice.h"
 
 using namespace Tempest;
+
+bool PaintDevice::addPolyline(const LinePoint*, size_t, uint8_t, uint8_t, const Rect&) {
+  return false;
+  }
@@ -47,6 +47,12 @@ class PaintDevice {
       float r=0,g=0,b=0,a=0;
       };
 
+    struct LinePoint {
+      float    x=0,y=0; // device pixels
+      uint32_t color=0; // RGBA8
+      float    width=0; // 0 - break between polylines
+      };
+
   protected:
     using TexPtr = Detail::ResourcePtr<Tempest::Texture2d>;
 
@@ -63,6 +69,12 @@ class PaintDevice {
     virtual void   setState(const Sprite& s, const Color& c)=0;
     virtual void   setTopology(Topology t)=0;
     virtual void   setBlend(const Blend b)=0;
+    virtual void   setDistanceField(bool df)=0;
+    // returns false, if device can't apply scissor at draw time and geometry has to be clipped by painter
+    virtual bool   setScissor(const Rect& sc)=0;
+    // polyline to be expanded into triangles by device, join/cap are Pen::JoinStyle/Pen::CapStyle
+    // returns false, if device can't do that and painter has to stroke polyline on cpu
+    virtual bool   addPolyline(const LinePoint* pt, size_t n, uint8_t join, uint8_t cap, const Rect& sc);
 
   friend class Painter;
   };
@@ -8,8 +8,45 @@
 
 #include "../utility/utf8_helper.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 using namespace Tempest;
 
+static constexpr float pi = 3.14159265358979323846f;
+
+static PointF rotateVec(const PointF& v, float angle) {
+  const float c = std::cos(angle), s = std::sin(angle);
+  return PointF(v.x*c - v.y*s, v.x*s + v.y*c);
+  }
+
+static PointF normalized(const PointF& v) {
+  const float l = v.length();
+  if(l<=0.f)
+    return PointF(0,0);
+  return v/l;
+  }
+
+static float cross(const PointF& a, const PointF& b) {
+  return a.x*b.y - a.y*b.x;
+  }
+
+static size_t arcSteps(float angle, float radius) {
+  // keep chord error of round joins and caps under a quarter of pixel
+  if(radius<=0.25f)
+    return 1;
+  const float step = 2.f*std::acos(1.f-0.25f/radius);
+  return std::clamp<size_t>(size_t(std::ceil(std::abs(angle)/step)),1,64);
+  }
+
+static void strokeProfile(float width, bool aa, float& core, float& outer, float& alpha) {
+  // analytic AA: opaque core and one pixel wide alpha ramp on both sides
+  core  = aa ? std::max(width*0.5f-0.5f,0.f) : width*0.5f;
+  outer = aa ? core+1.f : core;
+  alpha = aa ? std::min(width,1.f) : 1.f;
+  }
+
 Painter::Painter(PaintEvent &ev, Mode m)
   : dev(ev.device()), ta(ev.ta) {
   s.fnt = Application::font();
@@ -22,6 +59,9 @@ Painter::Painter(PaintEvent &ev, Mode m)
                        float(dp.x), float(dp.y), 1);
   s.tr.invW = 2.f/(ev.w());
   s.tr.invH = 2.f/(ev.h());
+  implUpdateTransform();
+
+  dev.beginPaint(m==Clear,ev.w(),ev.h());
 
   const Rect&  r = ev.viewPort();
   s.scRect.ox = dp.x;
@@ -29,7 +69,6 @@ Painter::Painter(PaintEvent &ev, Mode m)
   setScissor(r.x,r.y,r.w,r.h);
 
   implSetColor(1,1,1,1);
-  dev.beginPaint(m==Clear,ev.w(),ev.h());
   }
 
 Painter::~Painter() {
@@ -46,6 +85,7 @@ void Painter::setScissor(int x, int y, int w, int h) {
     std::swap(s.scRect.x,s.scRect.x1);
   if(s.scRect.y>s.scRect.y1)
     std::swap(s.scRect.y,s.scRect.y1);
+  implScissor();
   }
 
 void Painter::setScissor(int x, int y, unsigned w, unsigned h) {
@@ -53,12 +93,18 @@ void Painter::setScissor(int x, int y, unsigned w, unsigned h) {
   s.scRect.y  = y;
   s.scRect.x1 = x+int(w);
   s.scRect.y1 = y+int(h);
+  implScissor();
   }
 
 void Painter::setScissor(const Rect& r) {
   setScissor(r.x,r.y,r.w,r.h);
   }
 
+void Painter::implScissor() {
+  const ScissorRect& sc = s.scRect;
+  hwScissor = dev.setScissor(Rect(sc.x,sc.y,std::max(sc.x1-sc.x,0),std::max(sc.y1-sc.y,0)));
+  }
+
 void Painter::implAddPoint(float x, float y, float u, float v) {
   pt.x=x*s.tr.invW-1.f;
   pt.y=y*s.tr.invH-1.f;
@@ -75,6 +121,40 @@ void Painter::implAddPoint(int x, int y, float u, float v) {
   dev.addPoint(pt);
   }
 
+void Painter::implAddPoint(const FPoint& p) {
+  pt.x=p.x*s.tr.invW-1.f;
+  pt.y=p.y*s.tr.invH-1.f;
+  pt.u=p.u;
+  pt.v=p.v;
+  if(T_LIKELY(p.a==1.f)) {
+    dev.addPoint(pt);
+    return;
+    }
+  const float a = pt.a;
+  pt.a = a*p.a;
+  dev.addPoint(pt);
+  pt.a = a;
+  }
+
+void Painter::implAddQuad(const float* ndc, float u1, float v1, float u2, float v2) {
+  // corners are x1y1, x2y1, x2y2, x1y2
+  const float uv[4][2] = {{u1,v1},{u2,v1},{u2,v2},{u1,v2}};
+  static const uint8_t index[6] = {0,1,2, 0,2,3};
+  for(auto i:index) {
+    pt.x = ndc[i*2+0];
+    pt.y = ndc[i*2+1];
+    pt.u = uv[i][0];
+    pt.v = uv[i][1];
+    dev.addPoint(pt);
+    }
+  }
+
+void Painter::implUpdateTransform() {
+  s.tr.ndc = s.tr.mat*Transform(s.tr.invW, 0,         0,
+                                0,         s.tr.invH, 0,
+                                -1.f,      -1.f,      1.f);
+  }
+
 void Painter::implSetColor(float r, float g, float b, float a) {
   pt.r=r;
   pt.g=g;
@@ -107,18 +187,29 @@ void Painter::implDrawTrig( float x0, float y0, float u0, float v0,
                             float x2, float y2, float u2, float v2,
                             FPoint* out,
                             int stage ) {
+  implDrawTrig(FPoint{x0,y0,u0,v0}, FPoint{x1,y1,u1,v1}, FPoint{x2,y2,u2,v2}, out, stage);
+  }
+
+void Painter::implDrawTrig(const FPoint& p0, const FPoint& p1, const FPoint& p2, FPoint* out, int stage) {
   ScissorRect& sc = s.scRect;
   FPoint*      r  = out;
 
-  float x[4] = {x0,x1,x2,x0};
-  float y[4] = {y0,y1,y2,y0};
-  float u[4] = {u0,u1,u2,u0};
-  float v[4] = {v0,v1,v2,v0};
+  if(T_LIKELY(hwScissor)) {
+    // device clips, only reject triangles outside of scissor
+    if((p0.x<sc.x  && p1.x<sc.x  && p2.x<sc.x ) ||
+       (p0.y<sc.y  && p1.y<sc.y  && p2.y<sc.y ) ||
+       (p0.x>sc.x1 && p1.x>sc.x1 && p2.x>sc.x1) ||
+       (p0.y>sc.y1 && p1.y>sc.y1 && p2.y>sc.y1))
+      return;
+    implAddPoint(p0);
+    implAddPoint(p1);
+    implAddPoint(p2);
+    return;
+    }
 
-  float mid;
-  float sx = 0.f;
-  bool  cs = false, ns = false;
+  const FPoint p[4] = {p0,p1,p2,p0};
 
+  float sx = 0.f;
   switch( stage ) {
     case 0: sx = float(sc.x);  break;
     case 1: sx = float(sc.y);  break;
@@ -127,68 +218,39 @@ void Painter::implDrawTrig( float x0, float y0, float u0, float v0,
     }
 
   for(int i=0;i<3;++i){
-    switch( stage ){
-      case 0:
-        cs = x[i]  >=sx;
-        ns = x[i+1]>=sx;
-        break;
-      case 1:
-        cs = y[i]  >=sx;
-        ns = y[i+1]>=sx;
-        break;
-      case 2:
-        cs = x[i]  <sx;
-        ns = x[i+1]<sx;
-        break;
-      case 3:
-        cs = y[i]  <sx;
-        ns = y[i+1]<sx;
-        break;
+    const float c0 = (stage%2==0) ? p[i  ].x : p[i  ].y;
+    const float c1 = (stage%2==0) ? p[i+1].x : p[i+1].y;
+
+    bool cs = false, ns = false;
+    if(stage<2) {
+      cs = c0>=sx;
+      ns = c1>=sx;
+      } else {
+      cs = c0<sx;
+      ns = c1<sx;
       }
 
     if(cs==ns){
       if( cs ){
-        *out = FPoint{float(x[i+1]),float(y[i+1]),float(u[i+1]),float(v[i+1])};
+        *out = p[i+1];
         ++out;
         }
       } else {
-      float dx = (x[i+1]-x[i]);
-      float dy = (y[i+1]-y[i]);
-      float du = (u[i+1]-u[i]);
-      float dv = (v[i+1]-v[i]);
+      const float k = (sx-c0)/(c1-c0);
+      const FPoint& a = p[i];
+      const FPoint& b = p[i+1];
+      *out = FPoint{a.x + (b.x-a.x)*k, a.y + (b.y-a.y)*k,
+                    a.u + (b.u-a.u)*k, a.v + (b.v-a.v)*k,
+                    a.a + (b.a-a.a)*k};
+      if(stage%2==0)
+        out->x = sx; else
+        out->y = sx;
+      ++out;
       if( ns ){
-        if(stage%2==0){
-          mid = y[i] + (dy*(sx-x[i]))/dx;
-          *out = FPoint{sx, mid,
-              u[i] + (du*(sx-x[i]))/dx,
-              v[i] + (dv*(sx-x[i]))/dx};   ++out;
-
-          *out = FPoint{float(x[i+1]),float(y[i+1]),float(u[i+1]),float(v[i+1])};
-          ++out;
-          } else {
-          mid = x[i] + (dx*(sx-y[i]))/dy;
-          *out = FPoint{mid, sx,
-              u[i] + (du*(sx-y[i]))/dy,
-              v[i] + (dv*(sx-y[i]))/dy};   ++out;
-
-          *out = FPoint{float(x[i+1]),float(y[i+1]),float(u[i+1]),float(v[i+1])};
-          ++out;
-          }
-        } else {
-        if(stage%2==0){
-          mid = y[i] + (dy*(sx-x[i]))/dx;
-          *out = FPoint{sx, mid,
-              u[i] + (du*(sx-x[i]))/dx,
-              v[i] + (dv*(sx-x[i]))/dx};   ++out;
-          } else {
-          mid = x[i] + (dx*(sx-y[i]))/dy;
-          *out = FPoint{mid, sx,
-              u[i] + (du*(sx-y[i]))/dy,
-              v[i] + (dv*(sx-y[i]))/dy};   ++out;
-          }
+        *out = b;
+        ++out;
         }
       }
-    cs = ns;
     }
 
   ptrdiff_t count = out-r;
@@ -196,16 +258,13 @@ void Painter::implDrawTrig( float x0, float y0, float u0, float v0,
 
   if( stage<3 ){
     for(ptrdiff_t i=0;i<=count;++i){
-      implDrawTrig( r[  0].x, r[  0].y, r[  0].u, r[  0].v,
-                    r[i+1].x, r[i+1].y, r[i+1].u, r[i+1].v,
-                    r[i+2].x, r[i+2].y, r[i+2].u, r[i+2].v,
-                    out, stage+1 );
+      implDrawTrig(r[0], r[i+1], r[i+2], out, stage+1);
       }
     } else {
     for(ptrdiff_t i=0;i<=count;++i){
-      implAddPoint(r[  0].x, r[  0].y, r[  0].u, r[  0].v);
-      implAddPoint(r[i+1].x, r[i+1].y, r[i+1].u, r[i+1].v);
-      implAddPoint(r[i+2].x, r[i+2].y, r[i+2].u, r[i+2].v);
+      implAddPoint(r[  0]);
+      implAddPoint(r[i+1]);
+      implAddPoint(r[i+2]);
       }
     }
   }
@@ -222,7 +281,7 @@ void Painter::setBrush(const Brush& b) {
   }
 
 void Painter::setPen(const Pen &p) {
-  if(state==StPen)
+  if(state==StPen || state==StStroke)
     implPen(p);
   s.pn = p;
   }
@@ -234,15 +293,55 @@ void Painter::implBrush(const Brush &b) {
     dev.setState(b.spr,b.color);
     }
   dev.setBlend(b.blend);
+  dev.setDistanceField(b.dField);
   implSetColor(b.color.r(),b.color.g(),b.color.b(),b.color.a());
   }
 
 void Painter::implPen(const Pen &p) {
   dev.setState(Brush::TexPtr(),p.color,TextureFormat::Undefined,ClampMode::Repeat);
   dev.setBlend(p.blend);
+  dev.setDistanceField(false);
   implSetColor(p.color.r(),p.color.g(),p.color.b(),p.color.a());
   }
 
+Brush Painter::implGlyphBrush(const Font::Letter& l, const Color& cl) {
+  Brush b(l.view,cl,PaintDevice::Alpha);
+  b.dField = l.distanceField;
+  return b;
+  }
+
+void Painter::implDrawGlyph(const Font& fx, char32_t c, float x, float y, float kH, float kV, const Color& cl) {
+  if(fx.isSubpixelPositioning() && s.tr.mat.type()==Transform::T_AxisAligned) {
+    // pen position in device pixels: glyph variant for fractional part, quad on whole pixels
+    float x0=0, y0=0, x1=0, y1=0, x2=0, y2=0;
+    s.tr.mat.map(x,    y,     x0,y0);
+    s.tr.mat.map(x+1.f,y,     x1,y1);
+    s.tr.mat.map(x,    y+1.f, x2,y2);
+    const float sx = x1-x0, sy = y2-y0;
+    if(sx>0.f && sy>0.f && y1==y0 && x2==x0) {
+      const float n  = float(FontElement::SubpixelPhases);
+      const float q  = std::round(x0*n);
+      const float ix = std::floor(q/n);
+      const float iy = std::round(y0);
+      auto&       v  = fx.letter(c,uint8_t(q-ix*n),ta);
+
+      setBrush(implGlyphBrush(v,cl));
+      drawRect(x+(ix+float(v.dpos.x)-x0)/sx, y+(iy+float(v.dpos.y)-y0)/sy,
+               float(v.size.w)/sx, float(v.size.h)/sy,
+               0.f,0.f,float(v.view.w()),float(v.view.h()));
+      return;
+      }
+    }
+
+  auto& v     = fx.letter(c,ta);
+  float dposX = float(v.dpos.x*kH), dposY = float(v.dpos.y*kV);
+  float szX   = float(v.size.w*kH), szY   = float(v.size.h*kV);
+
+  setBrush(implGlyphBrush(v,cl));
+  drawRect(x+dposX,y+dposY,szX,szY,
+           0.f,0.f,float(v.view.w()),float(v.view.h()));
+  }
+
 void Painter::implDrawRect(int x1, int y1, int x2, int y2, float u1, float v1, float u2, float v2) {
   if(state!=StBrush) {
     dev.setTopology(Triangles);
@@ -266,64 +365,49 @@ void Painter::implDrawRect(int x1, int y1, int x2, int y2, float u1, float v1, f
       std::swap(v1,v2);
       }
 
-    float invW = (u2-u1)/float(x2-x1);
-    float invH = (v2-v1)/float(y2-y1);
-
     ScissorRect& sc = s.scRect;
-    if(x1<sc.x){
-      int dx=sc.x-x1;
-      x1+=dx;
-      if(x1>=x2)
-        return;
-      u1+=dx*invW;
-      }
+    if(x2<=sc.x || sc.x1<=x1 || y2<=sc.y || sc.y1<=y1)
+      return;
 
-    if(sc.x1<x2){
-      int dx=sc.x1-x2;
-      x2+=dx;
-      if(x1>=x2)
-        return;
-      u2+=dx*invW;
-      }
+    if(T_UNLIKELY(!hwScissor)) {
+      float invW = (u2-u1)/float(x2-x1);
+      float invH = (v2-v1)/float(y2-y1);
 
-    if(y1<sc.y){
-      int dy=sc.y-y1;
-      y1+=dy;
-      if(y1>=y2)
-        return;
-      v1+=dy*invH;
-      }
+      if(x1<sc.x){
+        int dx=sc.x-x1;
+        x1+=dx;
+        u1+=dx*invW;
+        }
+
+      if(sc.x1<x2){
+        int dx=sc.x1-x2;
+        x2+=dx;
+        u2+=dx*invW;
+        }
+
+      if(y1<sc.y){
+        int dy=sc.y-y1;
+        y1+=dy;
+        v1+=dy*invH;
+        }
+
+      if(sc.y1<y2){
+        int dy=sc.y1-y2;
+        y2+=dy;
+        v2+=dy*invH;
+        }
 
-    if(sc.y1<y2){
-      int dy=sc.y1-y2;
-      y2+=dy;
-      if(y1>=y2)
+      if(x1>=x2 || y1>=y2)
         return;
-      v2+=dy*invH;
       }
 
-    implAddPoint(x1,y1, u1,v1);
-    implAddPoint(x2,y1, u2,v1);
-    implAddPoint(x2,y2, u2,v2);
-
-    implAddPoint(x1,y1, u1,v1);
-    implAddPoint(x2,y2, u2,v2);
-    implAddPoint(x1,y2, u1,v2);
+    const float nx1 = float(x1)*s.tr.invW-1.f, nx2 = float(x2)*s.tr.invW-1.f;
+    const float ny1 = float(y1)*s.tr.invH-1.f, ny2 = float(y2)*s.tr.invH-1.f;
+    const float ndc[8] = {nx1,ny1, nx2,ny1, nx2,ny2, nx1,ny2};
+    implAddQuad(ndc,u1,v1,u2,v2);
     } else {
-    float x[4] = {float(x1), float(x2), float(x2), float(x1)};
-    float y[4] = {float(y1), float(y1), float(y2), float(y2)};
-    for(size_t i=0;i<4;++i)
-      s.tr.mat.map(x[i],y[i],x[i],y[i]);
-
-    FPoint trigBuf[4+4+4+4];
-    implDrawTrig( x[0], y[0], u1, v1,
-                  x[1], y[1], u2, v1,
-                  x[2], y[2], u2, v2,
-                  trigBuf, 0 );
-    implDrawTrig(x[0],y[0], u1,v1,
-                 x[2],y[2], u2,v2,
-                 x[3],y[3], u1,v2,
-                 trigBuf, 0 );
+    const float xy[8] = {float(x1),float(y1), float(x2),float(y1), float(x2),float(y2), float(x1),float(y2)};
+    implDrawQuad(xy,u1,v1,u2,v2);
     }
   }
 
@@ -333,20 +417,40 @@ void Painter::implDrawRectF(float x1, float y1, float x2, float y2, float u1, fl
     state=StBrush;
     implBrush(s.br);
     }
-  float x[4] = {float(x1), float(x2), float(x2), float(x1)};
-  float y[4] = {float(y1), float(y1), float(y2), float(y2)};
-  for(size_t i=0;i<4;++i)
-    s.tr.mat.map(x[i],y[i],x[i],y[i]);
+  const float xy[8] = {x1,y1, x2,y1, x2,y2, x1,y2};
+  implDrawQuad(xy,u1,v1,u2,v2);
+  }
+
+void Painter::implDrawQuad(const float* xy, float u1, float v1, float u2, float v2) {
+  if(T_LIKELY(hwScissor)) {
+    // map straight to NDC, device clips - only reject quads outside of scissor
+    float ndc[8];
+    s.tr.ndc.mapN(xy,ndc,4);
+
+    const ScissorRect& sc = s.scRect;
+    const float sx0 = float(sc.x )*s.tr.invW-1.f, sy0 = float(sc.y )*s.tr.invH-1.f;
+    const float sx1 = float(sc.x1)*s.tr.invW-1.f, sy1 = float(sc.y1)*s.tr.invH-1.f;
+    if((ndc[0]<sx0 && ndc[2]<sx0 && ndc[4]<sx0 && ndc[6]<sx0) ||
+       (ndc[1]<sy0 && ndc[3]<sy0 && ndc[5]<sy0 && ndc[7]<sy0) ||
+       (ndc[0]>sx1 && ndc[2]>sx1 && ndc[4]>sx1 && ndc[6]>sx1) ||
+       (ndc[1]>sy1 && ndc[3]>sy1 && ndc[5]>sy1 && ndc[7]>sy1))
+      return;
+    implAddQuad(ndc,u1,v1,u2,v2);
+    return;
+    }
+
+  float d[8];
+  s.tr.mat.mapN(xy,d,4);
 
   FPoint trigBuf[4+4+4+4];
-  implDrawTrig( x[0], y[0], u1, v1,
-      x[1], y[1], u2, v1,
-      x[2], y[2], u2, v2,
-      trigBuf, 0 );
-  implDrawTrig(x[0],y[0], u1,v1,
-      x[2],y[2], u2,v2,
-      x[3],y[3], u1,v2,
-      trigBuf, 0 );
+  implDrawTrig( d[0], d[1], u1, v1,
+                d[2], d[3], u2, v1,
+                d[4], d[5], u2, v2,
+                trigBuf, 0 );
+  implDrawTrig( d[0], d[1], u1, v1,
+                d[4], d[5], u2, v2,
+                d[6], d[7], u1, v2,
+                trigBuf, 0 );
   }
 
 void Painter::implDrawWideLine(float width, int x1, int y1, int x2, int y2) {
@@ -362,21 +466,11 @@ void Painter::implDrawWideLine(float width, int x1, int y1, int x2, int y2) {
     implBrush(s.br);
     }
 
-  float u1 = 0, v1 = 0, u2 = 0, v2 = 0;
-  float x[4] = {float(x1)-ortho.x, float(x2)-ortho.x, float(x2)+ortho.x, float(x1)+ortho.x};
-  float y[4] = {float(y1)-ortho.y, float(y2)-ortho.y, float(y2)+ortho.y, float(y1)+ortho.y};
-  for(size_t i=0;i<4;++i)
-    s.tr.mat.map(x[i],y[i],x[i],y[i]);
-
-  FPoint trigBuf[4+4+4+4];
-  implDrawTrig( x[0], y[0], u1, v1,
-      x[1], y[1], u2, v1,
-      x[2], y[2], u2, v2,
-      trigBuf, 0 );
-  implDrawTrig(x[0],y[0], u1,v1,
-      x[2],y[2], u2,v2,
-      x[3],y[3], u1,v2,
-      trigBuf, 0 );
+  const float xy[8] = {float(x1)-ortho.x, float(y1)-ortho.y,
+                       float(x2)-ortho.x, float(y2)-ortho.y,
+                       float(x2)+ortho.x, float(y2)+ortho.y,
+                       float(x1)+ortho.x, float(y1)+ortho.y};
+  implDrawQuad(xy,0,0,0,0);
   }
 
 void Painter::drawRect(float x, float y, float w, float h, float u1, float v1, float u2, float v2) {
@@ -426,11 +520,6 @@ void Painter::drawLine(int ix1, int iy1, int ix2, int iy2) {
   s.tr.mat.map(float(ix1),float(iy1),x1,y1);
   s.tr.mat.map(float(ix2),float(iy2),x2,y2);
 
-  if( x2<x1 ){
-    std::swap(x2, x1);
-    std::swap(y2, y1);
-    }
-
   if(x1>sc.x1 && x2>sc.x1)
     return;
   if(x1<sc.x  && x2<sc.x)
@@ -440,16 +529,36 @@ void Painter::drawLine(int ix1, int iy1, int ix2, int iy2) {
   if(y1<sc.y  && y2<sc.y)
     return;
 
+  if(T_UNLIKELY(!hwScissor) && !implClipLine(x1,y1,x2,y2))
+    return;
+
+  if(state!=StPen){
+    dev.setTopology(Lines);
+    state=StPen;
+    implPen(s.pn);
+    }
+  implAddPoint(x1+0.5f,y1+0.5f, 0,0);
+  implAddPoint(x2+0.5f,y2+0.5f, 0,0);
+  }
+
+bool Painter::implClipLine(float& x1, float& y1, float& x2, float& y2) const {
+  const ScissorRect& sc = s.scRect;
+
+  if( x2<x1 ){
+    std::swap(x2, x1);
+    std::swap(y2, y1);
+    }
+
   if( x1<sc.x ){
     if(std::fabs(x1-x2)<0.0001f)
-      return;
+      return false;
     y1 += (sc.x-x1)*(y2-y1)/(x2-x1);
     x1 = float(sc.x);
     }
 
   if( x2 > sc.x1 ){
     if(std::fabs(x1-x2)<0.0001f)
-      return;
+      return false;
     y2 += (sc.x1-x2)*(y2-y1)/(x2-x1);
     x2 = float(sc.x1);
     }
@@ -461,29 +570,448 @@ void Painter::drawLine(int ix1, int iy1, int ix2, int iy2) {
 
   if( y1<sc.y ){
     if(std::fabs(y1-y2)<0.0001f)
-      return;
+      return false;
     x1 += (sc.y-y1)*(x2-x1)/(y2-y1);
     y1 = float(sc.y);
     }
 
   if( y2 > sc.y1 ){
     if(std::fabs(y1-y2)<0.0001f)
-      return;
+      return false;
     x2 += (sc.y1-y2)*(x2-x1)/(y2-y1);
     y2 = float(sc.y1);
     }
+  return true;
+  }
 
-  if(state!=StPen){
-    dev.setTopology(Lines);
-    state=StPen;
+void Painter::drawLine(const Point& a, const Point& b) {
+  drawLine(a.x,a.y,b.x,b.y);
+  }
+
+void Painter::drawPath(const PainterPath& p) {
+  fillPath(p);
+  strokePath(p);
+  }
+
+void Painter::drawPolyline(const PointF* pt, size_t n, float w) {
+  const float width = w*s.tr.mat.scaleHint();
+  if(n<2 || !(width>0.f))
+    return;
+
+  auto& dpt = pathBuf.dev;
+  dpt.resize(n);
+  s.tr.mat.mapN(&pt[0].x,&dpt[0].x,n);
+
+  // drop repeated points, segments must have direction
+  float  x0 = dpt[0].x, y0 = dpt[0].y, x1 = x0, y1 = y0;
+  size_t cnt = 1;
+  for(size_t i=1; i<n; ++i) {
+    if(dpt[i]==dpt[cnt-1])
+      continue;
+    dpt[cnt] = dpt[i];
+    x0 = std::min(x0,dpt[cnt].x);
+    y0 = std::min(y0,dpt[cnt].y);
+    x1 = std::max(x1,dpt[cnt].x);
+    y1 = std::max(y1,dpt[cnt].y);
+    ++cnt;
+    }
+  if(cnt<2)
+    return;
+
+  const ScissorRect& sc     = s.scRect;
+  const float        margin = width*2.f+1.f;
+  if(x1+margin<float(sc.x) || float(sc.x1)<x0-margin || y1+margin<float(sc.y) || float(sc.y1)<y0-margin)
+    return;
+
+  if(state!=StStroke) {
+    dev.setTopology(Triangles);
+    state=StStroke;
     implPen(s.pn);
     }
-  implAddPoint(x1+0.5f,y1+0.5f, 0,0);
-  implAddPoint(x2+0.5f,y2+0.5f, 0,0);
+
+  const Color&   c  = s.pn.color;
+  const uint32_t cl = uint32_t(std::lround(std::clamp(c.r(),0.f,1.f)*255.f))       |
+                      uint32_t(std::lround(std::clamp(c.g(),0.f,1.f)*255.f)) << 8  |
+                      uint32_t(std::lround(std::clamp(c.b(),0.f,1.f)*255.f)) << 16 |
+                      uint32_t(std::lround(std::clamp(c.a(),0.f,1.f)*255.f)) << 24;
+  auto& ln = pathBuf.line;
+  ln.resize(cnt);
+  for(size_t i=0; i<cnt; ++i) {
+    ln[i].x     = dpt[i].x;
+    ln[i].y     = dpt[i].y;
+    ln[i].color = cl;
+    ln[i].width = width;
+    }
+  const Rect scRect(sc.x,sc.y,std::max(sc.x1-sc.x,0),std::max(sc.y1-sc.y,0));
+  if(dev.addPolyline(ln.data(),cnt,s.pn.join,s.pn.cap,scRect))
+    return;
+
+  float core = 0, outer = 0, alpha = 0;
+  strokeProfile(width,s.pn.blend==Alpha,core,outer,alpha);
+  pathBuf.clip = !hwScissor && (x0-margin<float(sc.x) || float(sc.x1)<x1+margin ||
+                                y0-margin<float(sc.y) || float(sc.y1)<y1+margin);
+  implStroke(dpt.data(),cnt,false,core,outer,alpha);
   }
 
-void Painter::drawLine(const Point& a, const Point& b) {
-  drawLine(a.x,a.y,b.x,b.y);
+void Painter::strokePath(const PainterPath& p) {
+  const float width = s.pn.width()*s.tr.mat.scaleHint();
+  if(!(width>0.f))
+    return;
+
+  float core = 0, outer = 0, alpha = 0;
+  strokeProfile(width,s.pn.blend==Alpha,core,outer,alpha);
+  const float miter = (s.pn.join==Pen::MiterJoin ? 4.f : 1.f);
+
+  if(!implFlatten(p,outer*miter))
+    return;
+
+  if(state!=StStroke) {
+    dev.setTopology(Triangles);
+    state=StStroke;
+    implPen(s.pn);
+    }
+
+  for(auto& c:pathBuf.contour)
+    implStroke(pathBuf.dev.data()+c.begin,c.size,c.closed,core,outer,alpha);
+  }
+
+void Painter::fillPath(const PainterPath& p) {
+  const bool aa = (s.br.blend==Alpha);
+  if(!implFlatten(p,aa ? 1.f : 0.f))
+    return;
+
+  if(state!=StBrush) {
+    dev.setTopology(Triangles);
+    state=StBrush;
+    implBrush(s.br);
+    }
+
+  for(auto& c:pathBuf.contour)
+    implFill(c,aa);
+  }
+
+bool Painter::implFlatten(const PainterPath& p, float margin) {
+  ScissorRect& sc = s.scRect;
+  if(sc.x>=sc.x1 || sc.y>=sc.y1)
+    return false;
+
+  const float tolerance = 0.25f/std::max(s.tr.mat.scaleHint(),1e-4f);
+  pathBuf.local.clear();
+  pathBuf.contour.clear();
+  p.flatten(tolerance,pathBuf.local,pathBuf.contour);
+  if(pathBuf.contour.size()==0)
+    return false;
+
+  auto& local = pathBuf.local;
+  auto& dpt   = pathBuf.dev;
+  dpt.resize(local.size());
+
+  s.tr.mat.mapN(&local[0].x,&dpt[0].x,local.size());
+
+  float x0 = std::numeric_limits<float>::max(), x1 = -x0;
+  float y0 = x0,                                y1 = -x0;
+  for(size_t i=0; i<dpt.size(); ++i) {
+    x0 = std::min(x0,dpt[i].x);
+    y0 = std::min(y0,dpt[i].y);
+    x1 = std::max(x1,dpt[i].x);
+    y1 = std::max(y1,dpt[i].y);
+    }
+
+  x0 -= margin;
+  y0 -= margin;
+  x1 += margin;
+  y1 += margin;
+  if(x1<float(sc.x) || float(sc.x1)<x0 || y1<float(sc.y) || float(sc.y1)<y0)
+    return false;
+  // per-triangle clipping only, if path crosses the scissor
+  pathBuf.clip = !hwScissor && (x0<float(sc.x) || float(sc.x1)<x1 || y0<float(sc.y) || float(sc.y1)<y1);
+  return true;
+  }
+
+void Painter::implPathTrig(const FPoint& a, const FPoint& b, const FPoint& c) {
+  if(T_LIKELY(!pathBuf.clip)) {
+    implAddPoint(a);
+    implAddPoint(b);
+    implAddPoint(c);
+    return;
+    }
+  FPoint trigBuf[4+4+4+4];
+  implDrawTrig(a,b,c,trigBuf,0);
+  }
+
+void Painter::implPathQuad(const FPoint& a, const FPoint& b, const FPoint& c, const FPoint& d) {
+  implPathTrig(a,b,c);
+  implPathTrig(a,c,d);
+  }
+
+void Painter::implStroke(const PointF* pt, size_t n, bool closed, float core, float outer, float alpha) {
+  struct Rail {
+    PointF l0, l1; // left:  core, fringe
+    PointF r0, r1; // right: core, fringe
+    };
+
+  auto mkRail = [](const PointF& at, const PointF& nl, const PointF& nr, float core, float outer) {
+    return Rail{at+nl*core, at+nl*outer, at+nr*core, at+nr*outer};
+    };
+
+  auto segment = [&](const Rail& a, const Rail& b) {
+    const FPoint al0{a.l0.x,a.l0.y,0,0,alpha}, ar0{a.r0.x,a.r0.y,0,0,alpha};
+    const FPoint bl0{b.l0.x,b.l0.y,0,0,alpha}, br0{b.r0.x,b.r0.y,0,0,alpha};
+    if(core>0.f)
+      implPathQuad(al0,ar0,br0,bl0);
+    if(outer>core) {
+      implPathQuad(FPoint{a.l1.x,a.l1.y,0,0,0},al0,bl0,FPoint{b.l1.x,b.l1.y,0,0,0});
+      implPathQuad(ar0,FPoint{a.r1.x,a.r1.y,0,0,0},FPoint{b.r1.x,b.r1.y,0,0,0},br0);
+      }
+    };
+
+  if(n<2)
+    return;
+  if(n==2)
+    closed = false;
+
+  const size_t segCnt = closed ? n : n-1;
+  const float  limit  = (s.pn.join==Pen::MiterJoin ? 4.f : 1.f);
+  const float  half   = (core+outer)*0.5f;
+
+  auto dirAt = [&](size_t i, float& len) {
+    const PointF d = pt[(i+1)%n]-pt[i];
+    len = d.length();
+    return len>0.f ? d/len : PointF(1,0);
+    };
+
+  // rails of vertex 'i' for incoming segment (in) and outgoing segment (out)
+  auto joinAt = [&](size_t i, const PointF& d0, float len0, const PointF& d1, float len1, Rail& in, Rail& out) {
+    const PointF& at = pt[i];
+    const PointF  n0 = PointF(-d0.y,d0.x);
+    const PointF  n1 = PointF(-d1.y,d1.x);
+    const float   cr = cross(d0,d1);
+
+    PointF m = n0+n1;
+    float  ml = m.length();
+    float  miterLen = 1.f;
+    if(ml>1e-4f) {
+      m        = m/ml;
+      miterLen = 1.f/std::max(PointF::dotProduct(m,n1),1e-4f);
+      }
+
+    if(std::abs(cr)<1e-4f && PointF::dotProduct(d0,d1)>0.f) {
+      in  = mkRail(at,n1,-n1,core,outer);
+      out = in;
+      return;
+      }
+    if(s.pn.join==Pen::MiterJoin && ml>1e-4f && miterLen<=limit) {
+      in  = mkRail(at,m*miterLen,-m*miterLen,core,outer);
+      out = in;
+      return;
+      }
+
+    // inner side shares clamped miter point, outer side is filled by bevel or round fan
+    const float  side   = (cr>0.f) ? -1.f : 1.f;
+    const float  innerK = (ml>1e-4f) ? std::min(miterLen,std::max(1.f,std::min(len0,len1)/std::max(outer,1.f))) : 0.f;
+    const PointF inner  = -m*(innerK*side);
+    if(side>0.f) {
+      in  = mkRail(at,n0,inner,core,outer);
+      out = mkRail(at,n1,inner,core,outer);
+      } else {
+      in  = mkRail(at,inner,-n0,core,outer);
+      out = mkRail(at,inner,-n1,core,outer);
+      }
+
+    const PointF a     = n0*side;
+    const PointF b     = n1*side;
+    const float  angle = std::atan2(cross(a,b),PointF::dotProduct(a,b));
+    const size_t steps = (s.pn.join==Pen::RoundJoin) ? arcSteps(angle,outer) : 1;
+    implStrokeFan(at,a,angle,steps,core,outer,alpha);
+    if(core>0.f) {
+      // segments end at line from outer rail to inner point, fill space between it and the fan
+      const PointF ic = at+inner*core, a0 = at+a*core, b0 = at+b*core;
+      const FPoint c{at.x,at.y,0,0,alpha}, fi{ic.x,ic.y,0,0,alpha};
+      implPathTrig(c,fi,FPoint{a0.x,a0.y,0,0,alpha});
+      implPathTrig(c,FPoint{b0.x,b0.y,0,0,alpha},fi);
+      }
+    };
+
+  float  len0 = 0, len1 = 0;
+  PointF d0   = dirAt(closed ? n-1 : 0, len0);
+  Rail   first, in, out;
+
+  if(closed) {
+    PointF d1 = dirAt(0,len1);
+    joinAt(0,d0,len0,d1,len1,first,out);
+    d0   = d1;
+    len0 = len1;
+    } else {
+    PointF at = pt[0];
+    PointF nl = PointF(-d0.y,d0.x);
+    if(s.pn.cap==Pen::SquareCap)
+      at = at - d0*half;
+    out = mkRail(at,nl,-nl,core,outer);
+    if(s.pn.cap==Pen::RoundCap)
+      implStrokeFan(pt[0],nl,pi,arcSteps(pi,outer),core,outer,alpha); else
+      implStrokeCap(at,-d0,core,outer,alpha);
+    }
+
+  for(size_t i=1; i<segCnt; ++i) {
+    PointF d1 = dirAt(i,len1);
+    Rail   nx;
+    joinAt(i,d0,len0,d1,len1,in,nx);
+    segment(out,in);
+    out  = nx;
+    d0   = d1;
+    len0 = len1;
+    }
+
+  if(closed) {
+    segment(out,first);
+    return;
+    }
+
+  PointF at = pt[n-1];
+  PointF nl = PointF(-d0.y,d0.x);
+  if(s.pn.cap==Pen::SquareCap)
+    at = at + d0*half;
+  in = mkRail(at,nl,-nl,core,outer);
+  segment(out,in);
+  if(s.pn.cap==Pen::RoundCap)
+    implStrokeFan(pt[n-1],-nl,pi,arcSteps(pi,outer),core,outer,alpha); else
+    implStrokeCap(at,d0,core,outer,alpha);
+  }
+
+void Painter::implStrokeFan(const PointF& at, const PointF& from, float angle, size_t steps,
+                            float core, float outer, float alpha) {
+  const FPoint c{at.x,at.y,0,0,alpha};
+  PointF v0 = from;
+  for(size_t i=1; i<=steps; ++i) {
+    const PointF v1 = (i==steps) ? rotateVec(from,angle) : rotateVec(from,angle*float(i)/float(steps));
+    const PointF a0 = at+v0*core, a1 = at+v1*core;
+    if(core>0.f)
+      implPathTrig(c,FPoint{a0.x,a0.y,0,0,alpha},FPoint{a1.x,a1.y,0,0,alpha});
+    if(outer>core) {
+      const PointF b0 = at+v0*outer, b1 = at+v1*outer;
+      implPathQuad(FPoint{a0.x,a0.y,0,0,alpha},FPoint{b0.x,b0.y,0,0,0},
+                   FPoint{b1.x,b1.y,0,0,0},    FPoint{a1.x,a1.y,0,0,alpha});
+      }
+    v0 = v1;
+    }
+  }
+
+void Painter::implStrokeCap(const PointF& at, const PointF& dir, float core, float outer, float alpha) {
+  const float f = outer-core;
+  if(f<=0.f)
+    return;
+  const PointF n  = PointF(-dir.y,dir.x);
+  const PointF dx = dir*f;
+
+  const PointF l0 = at+n*core, l1 = at+n*outer;
+  const PointF r0 = at-n*core, r1 = at-n*outer;
+
+  const FPoint fl0{l0.x,l0.y,0,0,alpha}, fr0{r0.x,r0.y,0,0,alpha};
+  const FPoint el0{l0.x+dx.x,l0.y+dx.y,0,0,0}, er0{r0.x+dx.x,r0.y+dx.y,0,0,0};
+  implPathQuad(FPoint{l1.x,l1.y,0,0,0},fl0,el0,FPoint{l1.x+dx.x,l1.y+dx.y,0,0,0});
+  if(core>0.f)
+    implPathQuad(fl0,fr0,er0,el0);
+  implPathQuad(fr0,FPoint{r1.x,r1.y,0,0,0},FPoint{r1.x+dx.x,r1.y+dx.y,0,0,0},er0);
+  }
+
+void Painter::implFill(const PainterPath::Contour& c, bool aa) {
+  const size_t  n     = c.size;
+  const PointF* dpt   = pathBuf.dev.data()+c.begin;
+  const PointF* local = pathBuf.local.data()+c.begin;
+  if(n<3)
+    return;
+
+  float area = 0;
+  for(size_t i=0; i<n; ++i)
+    area += cross(dpt[i],dpt[(i+1)%n]);
+  if(area==0.f)
+    return;
+  const float orient = (area>0.f) ? 1.f : -1.f;
+
+  // outward miter normals: core is inset by half of pixel, fringe is outset by half of pixel
+  auto& norm = pathBuf.norm;
+  norm.resize(n);
+  for(size_t i=0; i<n; ++i) {
+    if(!aa) {
+      norm[i] = PointF(0,0);
+      continue;
+      }
+    const PointF d0 = normalized(dpt[i]-dpt[(i+n-1)%n]);
+    const PointF d1 = normalized(dpt[(i+1)%n]-dpt[i]);
+    const PointF n0 = PointF(d0.y,-d0.x)*orient;
+    const PointF n1 = PointF(d1.y,-d1.x)*orient;
+    const PointF m  = normalized(n0+n1);
+    const float  k  = PointF::dotProduct(m,n1);
+    norm[i] = m*(0.5f/std::max(k,0.25f));
+    }
+
+  auto vertex = [&](size_t i, float sign, float a) {
+    const PointF p = dpt[i]+norm[i]*sign;
+    return FPoint{p.x,p.y, s.dU+local[i].x*s.invW, s.dV+local[i].y*s.invH, a};
+    };
+
+  // triangulation by ear clipping; convex contours degenerate into a fan
+  auto& link = pathBuf.link;
+  link.resize(n*2);
+  uint32_t* next = link.data();
+  uint32_t* prev = link.data()+n;
+  for(size_t i=0; i<n; ++i) {
+    next[i] = uint32_t((i+1)%n);
+    prev[i] = uint32_t((i+n-1)%n);
+    }
+
+  auto isConvex = [&](uint32_t a, uint32_t b, uint32_t c) {
+    return cross(dpt[b]-dpt[a],dpt[c]-dpt[b])*orient>0.f;
+    };
+  auto inside = [&](uint32_t a, uint32_t b, uint32_t c, const PointF& p) {
+    const float c0 = cross(dpt[b]-dpt[a],p-dpt[a])*orient;
+    const float c1 = cross(dpt[c]-dpt[b],p-dpt[b])*orient;
+    const float c2 = cross(dpt[a]-dpt[c],p-dpt[c])*orient;
+    return c0>=0.f && c1>=0.f && c2>=0.f;
+    };
+
+  bool convex = true;
+  for(uint32_t i=0; i<n && convex; ++i)
+    convex = isConvex(prev[i],i,next[i]) || cross(dpt[i]-dpt[prev[i]],dpt[next[i]]-dpt[i])==0.f;
+
+  if(convex) {
+    for(size_t i=1; i+1<n; ++i)
+      implPathTrig(vertex(0,-1,1),vertex(i,-1,1),vertex(i+1,-1,1));
+    } else {
+    size_t   left  = n;
+    uint32_t i     = 0;
+    size_t   guard = 0;
+    while(left>3) {
+      const uint32_t a = prev[i], c = next[i];
+      bool ear = isConvex(a,i,c);
+      for(uint32_t j=next[c]; ear && j!=a; j=next[j]) {
+        if(dpt[j]==dpt[a] || dpt[j]==dpt[i] || dpt[j]==dpt[c])
+          continue;
+        if(!isConvex(prev[j],j,next[j]) && inside(a,i,c,dpt[j]))
+          ear = false;
+        }
+      if(ear || guard>left) {
+        // self-intersecting contour: guard forces progress
+        implPathTrig(vertex(a,-1,1),vertex(i,-1,1),vertex(c,-1,1));
+        next[a] = c;
+        prev[c] = a;
+        --left;
+        guard   = 0;
+        i       = a;
+        } else {
+        i = c;
+        ++guard;
+        }
+      }
+    implPathTrig(vertex(prev[i],-1,1),vertex(i,-1,1),vertex(next[i],-1,1));
+    }
+
+  if(!aa)
+    return;
+  for(size_t i=0; i<n; ++i) {
+    const size_t j = (i+1)%n;
+    implPathQuad(vertex(i,-1,1),vertex(i,1,0),vertex(j,1,0),vertex(j,-1,1));
+    }
   }
 
 void Painter::setFont(const Font &f) {
@@ -492,18 +1020,22 @@ void Painter::setFont(const Font &f) {
 
 void Painter::translate(const Point& p) {
   s.tr.mat.translate(p);
+  implUpdateTransform();
   }
 
 void Painter::translate(int x, int y) {
   s.tr.mat.translate(float(x),float(y));
+  implUpdateTransform();
   }
 
 void Painter::rotate(float angle) {
   s.tr.mat.rotate(angle);
+  implUpdateTransform();
   }
 
 void Painter::scale(float x, float y) {
   s.tr.mat.scale(x,y);
+  implUpdateTransform();
   }
 
 void Painter::pushState() {
@@ -513,10 +1045,12 @@ void Painter::pushState() {
 void Painter::popState() {
   s = std::move(stStk.back());
   stStk.pop_back();
+  implScissor();
   switch(state) {
     case StNo: break;
     case StBrush: implBrush(s.br); break;
     case StPen:   implPen  (s.pn); break;
+    case StStroke:implPen  (s.pn); break;
     }
   }
 
@@ -529,6 +1063,7 @@ void Painter::drawText(int x, int y, const char *txt) {
   const float kV = 1.f/s.tr.mat.scaleHintV();
   fx.setPixelSize(std::ceil(fx.pixelSize()*s.tr.mat.scaleHint()));
   Utf8Iterator i(txt);
+  char32_t     prev = 0;
   while(i.hasData()) {
     auto c = i.next();
     if(c=='\0'){
@@ -536,16 +1071,11 @@ void Painter::drawText(int x, int y, const char *txt) {
       return;
       }
 
+    x   += s.fnt.kerning(prev,c);
+    prev = c;
     auto l = s.fnt.letterGeometry(c);
-    if(!l.size.isEmpty()) {
-      auto& v     = fx.letter(c,ta);
-      float dposX = float(v.dpos.x*kH), dposY = float(v.dpos.y*kV);
-      float szX   = float(v.size.w*kH), szY   = float(v.size.h*kV);
-
-      setBrush(Brush(v.view,pb.color,PaintDevice::Alpha));
-      drawRect(float(x)+dposX,float(y)+dposY,szX,szY,
-               0.f,0.f,float(v.view.w()),float(v.view.h()));
-      }
+    if(!l.size.isEmpty())
+      implDrawGlyph(fx,c,float(x),float(y),kH,kV,pb.color);
 
     x += l.advance.x;
     }
@@ -561,17 +1091,13 @@ void Painter::drawText(int x, int y, const char16_t *txt) {
   const float kV = 1.f/s.tr.mat.scaleHintV();
   fx.setPixelSize(fx.pixelSize()*s.tr.mat.scaleHint());
 
+  char16_t prev = 0;
   for(;*txt;++txt) {
+    x   += s.fnt.kerning(prev,*txt);
+    prev = *txt;
     auto l = s.fnt.letterGeometry(*txt);
-    if(!l.size.isEmpty()) {
-      auto& v     = fx.letter(*txt,ta);
-      float dposX = float(v.dpos.x*kH), dposY = float(v.dpos.y*kV);
-      float szX   = float(v.size.w*kH), szY   = float(v.size.h*kV);
-
-      setBrush(Brush(v.view,pb.color,PaintDevice::Alpha));
-      drawRect(float(x)+dposX,float(y)+dposY,szX,szY,
-               0.f,0.f,float(v.view.w()),float(v.view.h()));
-      }
+    if(!l.size.isEmpty())
+      implDrawGlyph(fx,char32_t(*txt),float(x),float(y),kH,kV,pb.color);
 
     x += l.advance.x;
     }
@@ -588,7 +1114,8 @@ void Painter::drawText(int x, int y, const std::u16string &txt) {
   }
 
 static int calcLineWidth(Utf8Iterator i, Utf8Iterator eol, const Font& fnt, TextureAtlas& ta) {
-  int x = 0;
+  int      x    = 0;
+  char32_t prev = 0;
   while(i!=eol){
     auto c=i.next();
     if(c=='\0')
@@ -596,7 +1123,8 @@ static int calcLineWidth(Utf8Iterator i, Utf8Iterator eol, const Font& fnt, Text
     if(c=='\n' || c=='\r')
       continue;
     auto l=fnt.letter(c,ta);
-    x += l.advance.x;
+    x   += l.advance.x + fnt.kerning(prev,c);
+    prev = c;
     }
   return x;
   }
@@ -672,6 +1200,7 @@ void Painter::drawText(int rx, int ry, int w, int h, const char *txt, AlignFlag
       x += (w-wl);
       }
 
+    char32_t prev = 0;
     while(i!=eol) {
       auto c=i.next();
       if(c=='\0'){
@@ -680,17 +1209,12 @@ void Painter::drawText(int rx, int ry, int w, int h, const char *txt, AlignFlag
         }
       if(c=='\n' || c=='\r')
         continue;
+      x   += s.fnt.kerning(prev,c);
+      prev = c;
       auto l=s.fnt.letterGeometry(c);
 
-      if(!l.size.isEmpty()) {
-        auto& v     = fx.letter(c,ta);
-        float dposX = float(v.dpos.x*kH), dposY = float(v.dpos.y*kV);
-        float szX   = float(v.size.w*kH), szY   = float(v.size.h*kV);
-
-        setBrush(Brush(v.view,pb.color,PaintDevice::Alpha));
-        drawRect(float(rx)+float(x)+dposX,float(ry)+float(y)+dposY,szX,szY,
-                 0.f,0.f,float(v.view.w()),float(v.view.h()));
-        }
+      if(!l.size.isEmpty())
+        implDrawGlyph(fx,c,float(rx+x),float(ry+y),kH,kV,pb.color);
 
       x += l.advance.x;
       }
@@ -5,6 +5,7 @@
 #include <Tempest/Font>
 #include <Tempest/Brush>
 #include <Tempest/Pen>
+#include <Tempest/PainterPath>
 
 namespace Tempest {
 
@@ -69,6 +70,14 @@ class Painter {
                        float x1, float y1, float u1, float v1,
                        float x2, float y2, float u2, float v2 );
 
+    // polyline with current pen color, blend, join and cap; width in local units.
+    // devices, that support it (VectorImage), expand it on gpu
+    void drawPolyline(const PointF* pt, size_t n, float width);
+
+    void drawPath  (const PainterPath& path);
+    void strokePath(const PainterPath& path);
+    void fillPath  (const PainterPath& path);
+
     void drawText(int x,int y,const char*     txt);
     void drawText(int x,int y,const char16_t* txt);
 
@@ -84,12 +93,14 @@ class Painter {
   private:
     enum State:uint8_t {
       StNo   =0,
-      StBrush=1,
-      StPen  =2
+      StBrush =1,
+      StPen   =2,
+      StStroke=3
       };
 
     struct Tr {
       Tempest::Transform mat  = Transform();
+      Tempest::Transform ndc  = Transform(); // mat followed by pixel to NDC mapping
       float              invW = 1.f;
       float              invH = 1.f;
       };
@@ -118,31 +129,63 @@ class Painter {
     PaintDevice::Point pt;
 
     State              state=StNo;
+    bool               hwScissor=false;
     InternalState      s;
     std::vector<InternalState> stStk;
 
     struct FPoint{
       float x,y;
       float u,v;
+      float a = 1.f;
+      };
+
+    struct PathBuffer {
+      std::vector<PainterPath::Contour>   contour;
+      std::vector<PointF>                 local;
+      std::vector<PointF>                 dev;
+      std::vector<PointF>                 norm;
+      std::vector<uint32_t>               link;
+      std::vector<PaintDevice::LinePoint> line;
+      bool                                clip = false;
       };
+    PathBuffer         pathBuf;
 
     void implBrush(const Brush& b);
     void implPen  (const Pen&   p);
 
+    static Brush implGlyphBrush(const Font::Letter& l, const Color& cl);
+    void implDrawGlyph(const Font& fx, char32_t c, float x, float y, float kH, float kV, const Color& cl);
+
     void implAddPoint(float x, float y, float u, float v);
     void implAddPoint(int   x, int   y, float u, float v);
+    void implAddPoint(const FPoint& p);
+    void implAddQuad (const float* ndc, float u1, float v1, float u2, float v2);
+    void implUpdateTransform();
     void implSetColor(float r,float g,float b,float a);
+    void implScissor();
+    bool implClipLine(float& x1, float& y1, float& x2, float& y2) const;
 
     void implDrawTrig( float x0, float y0, float u0, float v0,
                        float x1, float y1, float u1, float v1,
                        float x2, float y2, float u2, float v2,
                        FPoint *out, int stage);
+    void implDrawTrig( const FPoint& p0, const FPoint& p1, const FPoint& p2,
+                       FPoint *out, int stage);
     void implDrawRect(int x1, int y1, int x2, int y2,
                       float u1, float v1, float u2, float v2);
     void implDrawRectF(float x1, float y1, float x2, float y2,
                        float u1, float v1, float u2, float v2);
+    void implDrawQuad(const float* xy, float u1, float v1, float u2, float v2);
     void implDrawWideLine(float width, int x1,int y1,int x2,int y2);
 
+    bool implFlatten   (const PainterPath& p, float margin);
+    void implPathTrig  (const FPoint& a, const FPoint& b, const FPoint& c);
+    void implPathQuad  (const FPoint& a, const FPoint& b, const FPoint& c, const FPoint& d);
+    void implStroke    (const PointF* pt, size_t n, bool closed, float core, float outer, float alpha);
+    void implStrokeFan (const PointF& at, const PointF& from, float angle, size_t steps, float core, float outer, float alpha);
+    void implStrokeCap (const PointF& at, const PointF& dir, float core, float outer, float alpha);
+    void implFill      (const PainterPath::Contour& c, bool aa);
+
     friend class Font;
   };
 
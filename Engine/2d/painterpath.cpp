@@ -0,0 +1,145 @@
+#include "painterpath.h"
+
+#include <cmath>
+#include <algorithm>
+
+using namespace Tempest;
+
+static void pushPoint(std::vector<PointF>& out, float x, float y) {
+  if(out.size()>0 && out.back().x==x && out.back().y==y)
+    return;
+  out.emplace_back(x,y);
+  }
+
+void PainterPath::moveTo(float x, float y) {
+  cmd.push_back(MoveTo);
+  pt.emplace_back(x,y);
+  }
+
+void PainterPath::lineTo(float x, float y) {
+  cmd.push_back(LineTo);
+  pt.emplace_back(x,y);
+  }
+
+void PainterPath::quadTo(float cx, float cy, float x, float y) {
+  cmd.push_back(QuadTo);
+  pt.emplace_back(cx,cy);
+  pt.emplace_back(x,y);
+  }
+
+void PainterPath::cubicTo(float c1x, float c1y, float c2x, float c2y, float x, float y) {
+  cmd.push_back(CubicTo);
+  pt.emplace_back(c1x,c1y);
+  pt.emplace_back(c2x,c2y);
+  pt.emplace_back(x,y);
+  }
+
+void PainterPath::close() {
+  cmd.push_back(Close);
+  }
+
+void PainterPath::clear() {
+  cmd.clear();
+  pt.clear();
+  }
+
+void PainterPath::flatten(float tolerance, std::vector<PointF>& out, std::vector<Contour>& contour) const {
+  // segment count is derived from the second difference of control points:
+  // chord error of uniform subdivision is bounded by |d2|/(8*n^2) for quads and 3*|d2|/(4*n^2) for cubics
+  const size_t maxSteps = 256;
+  const PointF* p   = pt.data();
+  PointF        cur = PointF(0,0), start = PointF(0,0);
+
+  auto beginContour = [&](const PointF& at) {
+    if(contour.size()>0 && contour.back().size<=1) {
+      // drop previous moveTo without any drawing
+      out.resize(contour.back().begin);
+      contour.pop_back();
+      }
+    Contour c;
+    c.begin = out.size();
+    contour.push_back(c);
+    out.push_back(at);
+    start = at;
+    };
+
+  auto ensureContour = [&]() {
+    if(contour.size()==0 || contour.back().closed)
+      beginContour(cur);
+    };
+
+  for(auto c:cmd) {
+    switch(c) {
+      case MoveTo: {
+        cur = *p++;
+        beginContour(cur);
+        break;
+        }
+      case LineTo: {
+        ensureContour();
+        cur = *p++;
+        pushPoint(out,cur.x,cur.y);
+        break;
+        }
+      case QuadTo: {
+        ensureContour();
+        const PointF c1 = p[0], e = p[1];
+        p += 2;
+
+        const PointF d2  = cur - c1*2.f + e;
+        const float  err = d2.length()/(8.f*tolerance);
+        const size_t n   = std::min(maxSteps, std::max<size_t>(1,size_t(std::ceil(std::sqrt(err)))));
+        for(size_t i=1; i<n; ++i) {
+          const float t  = float(i)/float(n);
+          const float it = 1.f-t;
+          const float x  = it*it*cur.x + 2.f*it*t*c1.x + t*t*e.x;
+          const float y  = it*it*cur.y + 2.f*it*t*c1.y + t*t*e.y;
+          pushPoint(out,x,y);
+          }
+        pushPoint(out,e.x,e.y);
+        cur = e;
+        break;
+        }
+      case CubicTo: {
+        ensureContour();
+        const PointF c1 = p[0], c2 = p[1], e = p[2];
+        p += 3;
+
+        const PointF d0  = cur - c1*2.f + c2;
+        const PointF d1  = c1  - c2*2.f + e;
+        const float  err = 0.75f*std::max(d0.length(),d1.length())/tolerance;
+        const size_t n   = std::min(maxSteps, std::max<size_t>(1,size_t(std::ceil(std::sqrt(err)))));
+        for(size_t i=1; i<n; ++i) {
+          const float t  = float(i)/float(n);
+          const float it = 1.f-t;
+          const float b0 = it*it*it, b1 = 3.f*it*it*t, b2 = 3.f*it*t*t, b3 = t*t*t;
+          pushPoint(out, b0*cur.x + b1*c1.x + b2*c2.x + b3*e.x,
+                         b0*cur.y + b1*c1.y + b2*c2.y + b3*e.y);
+          }
+        pushPoint(out,e.x,e.y);
+        cur = e;
+        break;
+        }
+      case Close: {
+        if(contour.size()==0 || contour.back().closed)
+          break;
+        auto& ct = contour.back();
+        // closing point is implicit
+        if(out.size()-ct.begin>1 && out.back()==out[ct.begin])
+          out.pop_back();
+        ct.closed = true;
+        ct.size   = out.size()-ct.begin;
+        cur       = start;
+        break;
+        }
+      }
+
+    if(contour.size()>0 && !contour.back().closed)
+      contour.back().size = out.size()-contour.back().begin;
+    }
+
+  if(contour.size()>0 && contour.back().size<=1) {
+    out.resize(contour.back().begin);
+    contour.pop_back();
+    }
+  }
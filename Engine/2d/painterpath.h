@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Tempest/Point>
+
+#include <vector>
+#include <cstdint>
+
+namespace Tempest {
+
+class PainterPath final {
+  public:
+    PainterPath()=default;
+
+    void moveTo (float x, float y);
+    void moveTo (const PointF& p) { moveTo(p.x,p.y); }
+
+    void lineTo (float x, float y);
+    void lineTo (const PointF& p) { lineTo(p.x,p.y); }
+
+    void quadTo (float cx, float cy, float x, float y);
+    void cubicTo(float c1x, float c1y, float c2x, float c2y, float x, float y);
+
+    void close();
+    void clear();
+
+    bool isEmpty() const { return cmd.empty(); }
+
+  private:
+    enum Command : uint8_t {
+      MoveTo,
+      LineTo,
+      QuadTo,
+      CubicTo,
+      Close
+      };
+
+    struct Contour {
+      size_t begin  = 0;
+      size_t size   = 0;
+      bool   closed = false;
+      };
+
+    std::vector<Command> cmd;
+    std::vector<PointF>  pt;
+
+    void flatten(float tolerance, std::vector<PointF>& out, std::vector<Contour>& contour) const;
+
+  friend class Painter;
+  };
+
+}
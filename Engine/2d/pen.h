@@ -7,15 +7,35 @@ namespace Tempest {
 
 class Pen {
   public:
+    enum CapStyle : uint8_t {
+      FlatCap,
+      SquareCap,
+      RoundCap
+      };
+
+    enum JoinStyle : uint8_t {
+      MiterJoin,
+      BevelJoin,
+      RoundJoin
+      };
+
     Pen()=default;
     Pen(const Color& cl, PaintDevice::Blend blend=PaintDevice::Alpha, float w=1.f);
 
-    float width() const { return penW; }
+    float     width() const { return penW; }
+
+    void      setCapStyle (CapStyle  c) { cap  = c; }
+    CapStyle  capStyle()  const { return cap;  }
+
+    void      setJoinStyle(JoinStyle j) { join = j; }
+    JoinStyle joinStyle() const { return join; }
 
   private:
     Color              color;
     PaintDevice::Blend blend = PaintDevice::NoBlend;
     float              penW=1.f;
+    CapStyle           cap  = FlatCap;
+    JoinStyle          join = MiterJoin;
 
   friend class Painter;
   };
@@ -0,0 +1,485 @@
+#include "rasterimage.h"
+
+#include <Tempest/Painter>
+#include <Tempest/Except>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+using namespace Tempest;
+
+namespace {
+
+enum {
+  TileSize = 64,
+  Lanes    = 4,
+  };
+
+struct Vert {
+  float x,y;
+  float u,v;
+  float r,g,b,a;
+  };
+
+struct Prim {
+  uint32_t v[3]    = {};
+  uint32_t block   = 0;
+  bool     line    = false;
+  // same color at all vertices and no texture: no per-pixel interpolation
+  bool     flat    = false;
+
+  // triangle edge functions: e = a*x + b*y + c, positive inside
+  float    ea[3]   = {}, eb[3] = {}, ec[3] = {};
+  bool     tl[3]   = {};
+  float    invArea = 0;
+  // uv derivatives, for distance-field antialiasing
+  float    dudx = 0, dvdx = 0, dudy = 0, dvdy = 0;
+
+  int      x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+  };
+
+struct Px {
+  float r,g,b,a;
+  };
+
+struct PageSampler {
+  const uint8_t* data = nullptr;
+  int            w    = 0;
+  int            h    = 0;
+  bool           mask = false; // R8 coverage page, sampled as (1,1,1,r)
+
+  Px fetch(int x, int y) const {
+    x = std::clamp(x,0,w-1);
+    y = std::clamp(y,0,h-1);
+    if(mask)
+      return Px{1.f, 1.f, 1.f, data[size_t(y)*size_t(w) + size_t(x)]/255.f};
+    const uint8_t* p = data + (size_t(y)*size_t(w) + size_t(x))*4;
+    return Px{p[0]/255.f, p[1]/255.f, p[2]/255.f, p[3]/255.f};
+    }
+
+  Px operator()(float u, float v) const {
+    const float fx = u*float(w)-0.5f;
+    const float fy = v*float(h)-0.5f;
+    const float ix = std::floor(fx), iy = std::floor(fy);
+    const float kx = fx-ix,          ky = fy-iy;
+    const int   x  = int(ix),        y  = int(iy);
+
+    const Px p00 = fetch(x,y),   p10 = fetch(x+1,y);
+    const Px p01 = fetch(x,y+1), p11 = fetch(x+1,y+1);
+    auto lerp = [&](float a, float b, float c, float d) {
+      const float t = a+(b-a)*kx;
+      const float s = c+(d-c)*kx;
+      return t+(s-t)*ky;
+      };
+    return Px{lerp(p00.r,p10.r,p01.r,p11.r), lerp(p00.g,p10.g,p01.g,p11.g),
+              lerp(p00.b,p10.b,p01.b,p11.b), lerp(p00.a,p10.a,p01.a,p11.a)};
+    }
+  };
+
+struct Frame {
+  std::vector<Vert>                  vert;
+  std::vector<Prim>                  prim;
+  std::vector<std::vector<uint32_t>> bins;
+  std::vector<PageSampler>           sampler;
+  uint32_t                           tilesX = 0;
+  uint32_t                           tilesY = 0;
+  };
+
+inline void blend(Px& dst, const Px& src, PaintDevice::Blend b) {
+  switch(b) {
+    case PaintDevice::NoBlend:
+      dst = src;
+      break;
+    case PaintDevice::Alpha: {
+      const float k = 1.f-src.a;
+      dst.r = src.r*src.a + dst.r*k;
+      dst.g = src.g*src.a + dst.g*k;
+      dst.b = src.b*src.a + dst.b*k;
+      dst.a = src.a*src.a + dst.a*k;
+      break;
+      }
+    case PaintDevice::Add:
+      dst.r = std::min(dst.r+src.r,1.f);
+      dst.g = std::min(dst.g+src.g,1.f);
+      dst.b = std::min(dst.b+src.b,1.f);
+      dst.a = std::min(dst.a+src.a,1.f);
+      break;
+    }
+  }
+
+inline float smoothstep(float e0, float e1, float x) {
+  const float t = std::clamp((x-e0)/(e1-e0),0.f,1.f);
+  return t*t*(3.f-2.f*t);
+  }
+}
+
+template<class T,T RasterImage::State::*param>
+void RasterImage::setState(const T &t) {
+  if(blocks.back().*param==t)
+    return;
+
+  if(blocks.back().size==0){
+    blocks.back().*param=t;
+    return;
+    }
+
+  blocks.push_back(blocks.back());
+  blocks.back().begin =buf.size();
+  blocks.back().size  =0;
+  blocks.back().*param=t;
+  }
+
+void RasterImage::beginPaint(bool clr, uint32_t w, uint32_t h) {
+  if(paintScope==0)
+    resetBlocks();
+  if(clr || out.isEmpty() || info.w!=w || info.h!=h) {
+    info.w = w;
+    info.h = h;
+    out    = Pixmap(w,h,TextureFormat::RGBA8);
+    std::memset(out.data(),0,out.dataSize());
+    }
+  paintScope++;
+  }
+
+void RasterImage::endPaint() {
+  paintScope--;
+  if(paintScope!=0)
+    return;
+  rasterize();
+  resetBlocks();
+  }
+
+size_t RasterImage::pushState() {
+  size_t sz=stateStk.size();
+  stateStk.push_back(blocks.back());
+  return sz;
+  }
+
+void RasterImage::popState(size_t id) {
+  State& s = stateStk[id];
+  State& b = blocks.back();
+  if(b==s)
+    return;
+  if(blocks.back().size==0) {
+    b=s;
+    } else {
+    blocks.emplace_back(s);
+    blocks.back().begin =buf.size();
+    blocks.back().size  =0;
+    }
+  stateStk.resize(id);
+  }
+
+void RasterImage::setState(const TexPtr& t, const Color&, TextureFormat, ClampMode) {
+  // gpu textures can't be sampled on cpu; drawing them with plain color would be silently wrong
+  if(t)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidTexture);
+  setState<Texture,&State::tex>(Texture());
+  }
+
+void RasterImage::setState(const Sprite& s, const Color&) {
+  Texture tex;
+  tex.sprite = s;
+  setState<Texture,&State::tex>(tex);
+  }
+
+void RasterImage::setTopology(Topology t) {
+  setState<Topology,&State::tp>(t);
+  }
+
+void RasterImage::setBlend(const Blend b) {
+  setState<Blend,&State::blend>(b);
+  }
+
+void RasterImage::setDistanceField(bool df) {
+  setState<bool,&State::dField>(df);
+  }
+
+bool RasterImage::setScissor(const Rect& sc) {
+  // scissor is free for tile rasterizer: primitive bounds are clamped to it
+  setState<bool,&State::hasScissor>(true);
+  setState<Rect,&State::scissor>(sc);
+  return true;
+  }
+
+void RasterImage::clear() {
+  resetBlocks();
+  if(!out.isEmpty())
+    std::memset(out.data(),0,out.dataSize());
+  }
+
+void RasterImage::resetBlocks() {
+  buf.clear();
+  blocks.resize(1);
+  blocks.back()=Block();
+  stateStk.clear();
+  }
+
+void RasterImage::addPoint(const PaintDevice::Point &p) {
+  buf.push_back(p);
+  blocks.back().size++;
+  }
+
+void RasterImage::commitPoints() {
+  while(blocks.size()>1){
+    if(blocks.back().size!=0)
+      return;
+    blocks.pop_back();
+    }
+  }
+
+void RasterImage::rasterize() {
+  if(out.isEmpty() || buf.empty())
+    return;
+
+  const int W = int(info.w);
+  const int H = int(info.h);
+
+  Frame f;
+  f.tilesX = (info.w+TileSize-1)/TileSize;
+  f.tilesY = (info.h+TileSize-1)/TileSize;
+  f.bins.resize(size_t(f.tilesX)*f.tilesY);
+
+  f.vert.resize(buf.size());
+  for(size_t i=0; i<buf.size(); ++i) {
+    auto& p = buf[i];
+    f.vert[i] = Vert{(p.x+1.f)*0.5f*float(W), (p.y+1.f)*0.5f*float(H), p.u, p.v, p.r, p.g, p.b, p.a};
+    }
+
+  f.sampler.resize(blocks.size());
+  for(size_t i=0; i<blocks.size(); ++i) {
+    auto& pm = blocks[i].tex.sprite.pagePixmap();
+    if(pm.isEmpty())
+      continue;
+    f.sampler[i] = PageSampler{reinterpret_cast<const uint8_t*>(pm.data()), int(pm.w()), int(pm.h()),
+                               pm.format()==TextureFormat::R8};
+    }
+
+  // setup and binning; bins keep submission order, so blending stays in order per pixel
+  for(size_t bId=0; bId<blocks.size(); ++bId) {
+    auto& b = blocks[bId];
+    Rect  sc(0,0,W,H);
+    if(b.hasScissor)
+      sc = sc.intersected(b.scissor);
+    if(sc.isEmpty())
+      continue;
+
+    const size_t stride = (b.tp==Lines ? 2 : 3);
+    for(size_t i=0; i+stride<=b.size; i+=stride) {
+      Prim pr;
+      pr.block = uint32_t(bId);
+      pr.v[0]  = uint32_t(b.begin+i);
+      pr.v[1]  = uint32_t(b.begin+i+1);
+      pr.v[2]  = uint32_t(b.begin+i+stride-1);
+
+      float minX, minY, maxX, maxY;
+      if(b.tp==Lines) {
+        auto& v0 = f.vert[pr.v[0]];
+        auto& v1 = f.vert[pr.v[1]];
+        pr.line  = true;
+        minX = std::min(v0.x,v1.x);
+        minY = std::min(v0.y,v1.y);
+        maxX = std::max(v0.x,v1.x)+1.f;
+        maxY = std::max(v0.y,v1.y)+1.f;
+        } else {
+        const Vert* v[3] = {&f.vert[pr.v[0]], &f.vert[pr.v[1]], &f.vert[pr.v[2]]};
+        float area = (v[2]->x-v[1]->x)*(v[0]->y-v[1]->y) - (v[2]->y-v[1]->y)*(v[0]->x-v[1]->x);
+        if(area==0.f || !std::isfinite(area))
+          continue;
+        if(area<0.f) {
+          std::swap(pr.v[1],pr.v[2]);
+          std::swap(v[1],v[2]);
+          area = -area;
+          }
+        for(int e=0; e<3; ++e) {
+          const Vert& p = *v[(e+1)%3];
+          const Vert& q = *v[(e+2)%3];
+          pr.ea[e] = p.y-q.y;
+          pr.eb[e] = q.x-p.x;
+          pr.ec[e] = p.x*q.y - q.x*p.y;
+          // top-left rule: shared edges are owned by exactly one of triangles
+          pr.tl[e] = (pr.ea[e]>0.f) || (pr.ea[e]==0.f && pr.eb[e]>0.f);
+          }
+        pr.invArea = 1.f/area;
+        pr.flat    = f.sampler[bId].data==nullptr &&
+                     v[0]->r==v[1]->r && v[0]->g==v[1]->g && v[0]->b==v[1]->b && v[0]->a==v[1]->a &&
+                     v[0]->r==v[2]->r && v[0]->g==v[2]->g && v[0]->b==v[2]->b && v[0]->a==v[2]->a;
+        for(int e=0; e<3; ++e) {
+          pr.dudx += v[e]->u*pr.ea[e]*pr.invArea;
+          pr.dvdx += v[e]->v*pr.ea[e]*pr.invArea;
+          pr.dudy += v[e]->u*pr.eb[e]*pr.invArea;
+          pr.dvdy += v[e]->v*pr.eb[e]*pr.invArea;
+          }
+        minX = std::min({v[0]->x,v[1]->x,v[2]->x});
+        minY = std::min({v[0]->y,v[1]->y,v[2]->y});
+        maxX = std::max({v[0]->x,v[1]->x,v[2]->x});
+        maxY = std::max({v[0]->y,v[1]->y,v[2]->y});
+        }
+
+      pr.x0 = std::max(int(std::floor(minX)),   sc.x);
+      pr.y0 = std::max(int(std::floor(minY)),   sc.y);
+      pr.x1 = std::min(int(std::ceil (maxX))+1, sc.x+sc.w);
+      pr.y1 = std::min(int(std::ceil (maxY))+1, sc.y+sc.h);
+      if(pr.x0>=pr.x1 || pr.y0>=pr.y1)
+        continue;
+
+      const uint32_t id = uint32_t(f.prim.size());
+      f.prim.push_back(pr);
+      for(int ty=pr.y0/TileSize; ty<=(pr.y1-1)/TileSize; ++ty)
+        for(int tx=pr.x0/TileSize; tx<=(pr.x1-1)/TileSize; ++tx)
+          f.bins[size_t(ty)*f.tilesX+size_t(tx)].push_back(id);
+      }
+    }
+
+  std::vector<uint32_t> tiles;
+  for(uint32_t i=0; i<f.bins.size(); ++i)
+    if(!f.bins[i].empty())
+      tiles.push_back(i);
+  if(tiles.empty())
+    return;
+
+  uint8_t* pixels = reinterpret_cast<uint8_t*>(out.data());
+
+  auto shade = [&](const Prim& pr, const Block& b, Px* tile, int tx0, int ty0, int x, int y,
+                   float l0, float l1, float l2) {
+    const Vert& v0 = f.vert[pr.v[0]];
+    const Vert& v1 = f.vert[pr.v[1]];
+    const Vert& v2 = f.vert[pr.v[2]];
+    Px src = Px{v0.r*l0 + v1.r*l1 + v2.r*l2,
+                v0.g*l0 + v1.g*l1 + v2.g*l2,
+                v0.b*l0 + v1.b*l1 + v2.b*l2,
+                v0.a*l0 + v1.a*l1 + v2.a*l2};
+
+    const PageSampler& smp = f.sampler[pr.block];
+    if(smp.data!=nullptr) {
+      const float u = v0.u*l0 + v1.u*l1 + v2.u*l2;
+      const float v = v0.v*l0 + v1.v*l1 + v2.v*l2;
+      if(b.dField) {
+        const float d  = smp(u,v).a;
+        const float dx = smp(u+pr.dudx,v+pr.dvdx).a - d;
+        const float dy = smp(u+pr.dudy,v+pr.dvdy).a - d;
+        const float aa = std::max(std::abs(dx)+std::abs(dy),1.f/255.f)*0.75f;
+        src.a *= smoothstep(0.5f-aa,0.5f+aa,d);
+        } else {
+        const Px t = smp(u,v);
+        src.r *= t.r;
+        src.g *= t.g;
+        src.b *= t.b;
+        src.a *= t.a;
+        }
+      }
+    blend(tile[(y-ty0)*TileSize + (x-tx0)],src,b.blend);
+    };
+
+  auto drawTrig = [&](const Prim& pr, const Block& b, Px* tile, int tx0, int ty0, int x0, int y0, int x1, int y1) {
+    for(int y=y0; y<y1; ++y) {
+      const float py = float(y)+0.5f;
+      float       row[3];
+      for(int e=0; e<3; ++e)
+        row[e] = pr.eb[e]*py + pr.ec[e];
+
+      for(int x=x0; x<x1; x+=Lanes) {
+        // edge functions for a span of pixels at once
+        float w[3][Lanes];
+        bool  in[Lanes];
+        for(int i=0; i<Lanes; ++i) {
+          const float px = float(x+i)+0.5f;
+          w[0][i] = pr.ea[0]*px + row[0];
+          w[1][i] = pr.ea[1]*px + row[1];
+          w[2][i] = pr.ea[2]*px + row[2];
+          in[i]   = (w[0][i]>0.f || (w[0][i]==0.f && pr.tl[0])) &&
+                    (w[1][i]>0.f || (w[1][i]==0.f && pr.tl[1])) &&
+                    (w[2][i]>0.f || (w[2][i]==0.f && pr.tl[2])) &&
+                    (x+i<x1);
+          }
+        if(pr.flat) {
+          const Vert& v0 = f.vert[pr.v[0]];
+          const Px    cl = Px{v0.r,v0.g,v0.b,v0.a};
+          Px*         dst = tile + (y-ty0)*TileSize + (x-tx0);
+          for(int i=0; i<Lanes; ++i)
+            if(in[i])
+              blend(dst[i],cl,b.blend);
+          continue;
+          }
+        for(int i=0; i<Lanes; ++i) {
+          if(!in[i])
+            continue;
+          const float l0 = w[0][i]*pr.invArea;
+          const float l1 = w[1][i]*pr.invArea;
+          shade(pr,b,tile,tx0,ty0,x+i,y,l0,l1,1.f-l0-l1);
+          }
+        }
+      }
+    };
+
+  auto drawLine = [&](const Prim& pr, const Block& b, Px* tile, int tx0, int ty0, int x0, int y0, int x1, int y1) {
+    const Vert& a  = f.vert[pr.v[0]];
+    const Vert& c  = f.vert[pr.v[1]];
+    const float dx = c.x-a.x, dy = c.y-a.y;
+    const int   n  = int(std::ceil(std::max(std::abs(dx),std::abs(dy))));
+    // last pixel is not drawn, to match gpu line rasterization
+    for(int i=0; i<n; ++i) {
+      const float t = float(i)/float(n);
+      const int   x = int(std::floor(a.x+dx*t));
+      const int   y = int(std::floor(a.y+dy*t));
+      if(x<x0 || y<y0 || x>=x1 || y>=y1)
+        continue;
+      shade(pr,b,tile,tx0,ty0,x,y,1.f-t,t,0.f);
+      }
+    };
+
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    std::vector<Px> tile(TileSize*TileSize);
+    while(true) {
+      const size_t id = next.fetch_add(1);
+      if(id>=tiles.size())
+        return;
+      const uint32_t tId = tiles[id];
+      const int      tx0 = int(tId%f.tilesX)*TileSize;
+      const int      ty0 = int(tId/f.tilesX)*TileSize;
+      const int      tx1 = std::min(tx0+TileSize,W);
+      const int      ty1 = std::min(ty0+TileSize,H);
+
+      for(int y=ty0; y<ty1; ++y)
+        for(int x=tx0; x<tx1; ++x) {
+          const uint8_t* p = pixels + (size_t(y)*size_t(W)+size_t(x))*4;
+          tile[size_t((y-ty0)*TileSize+(x-tx0))] = Px{p[0]/255.f, p[1]/255.f, p[2]/255.f, p[3]/255.f};
+          }
+
+      for(auto i:f.bins[tId]) {
+        const Prim&  pr = f.prim[i];
+        const Block& b  = blocks[pr.block];
+        const int    x0 = std::max(pr.x0,tx0), y0 = std::max(pr.y0,ty0);
+        const int    x1 = std::min(pr.x1,tx1), y1 = std::min(pr.y1,ty1);
+        if(pr.line)
+          drawLine(pr,b,tile.data(),tx0,ty0,x0,y0,x1,y1); else
+          drawTrig(pr,b,tile.data(),tx0,ty0,x0,y0,x1,y1);
+        }
+
+      for(int y=ty0; y<ty1; ++y)
+        for(int x=tx0; x<tx1; ++x) {
+          const Px& s = tile[size_t((y-ty0)*TileSize+(x-tx0))];
+          uint8_t*  p = pixels + (size_t(y)*size_t(W)+size_t(x))*4;
+          p[0] = uint8_t(std::clamp(s.r,0.f,1.f)*255.f+0.5f);
+          p[1] = uint8_t(std::clamp(s.g,0.f,1.f)*255.f+0.5f);
+          p[2] = uint8_t(std::clamp(s.b,0.f,1.f)*255.f+0.5f);
+          p[3] = uint8_t(std::clamp(s.a,0.f,1.f)*255.f+0.5f);
+          }
+      }
+    };
+
+  size_t thCount = (threads==0 ? std::thread::hardware_concurrency() : threads);
+  thCount = std::clamp<size_t>(thCount,1,tiles.size());
+
+  std::vector<std::thread> th;
+  th.reserve(thCount-1);
+  for(size_t i=1; i<thCount; ++i)
+    th.emplace_back(worker);
+  worker();
+  for(auto& t:th)
+    t.join();
+  }
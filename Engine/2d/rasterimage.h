@@ -0,0 +1,95 @@
+#pragma once
+
+#include <Tempest/PaintDevice>
+#include <Tempest/Pixmap>
+#include <Tempest/Rect>
+#include <Tempest/Sprite>
+
+#include <vector>
+
+namespace Tempest {
+
+// Software paint device: records Painter output and rasterizes it into RGBA8 pixmap at the end of painting.
+// Doesn't require graphics Device (paint with cpu-only TextureAtlas), so can be used for thumbnails,
+// golden-image tests and headless export. Sprites are sampled from atlas pages; brushes with gpu Texture2d
+// can't be read back and are rejected with GraphicsErrc::InvalidTexture.
+class RasterImage : public Tempest::PaintDevice {
+  public:
+    RasterImage()=default;
+
+    uint32_t      w() const { return info.w; }
+    uint32_t      h() const { return info.h; }
+
+    const Pixmap& pixmap() const { return out; }
+
+    // 0 - use all hardware threads
+    void          setThreadCount(uint32_t n) { threads = n; }
+    void          clear() override;
+
+  private:
+    void   addPoint(const Point& p) override;
+    void   commitPoints() override;
+
+    void   beginPaint(bool clear,uint32_t w,uint32_t h) override;
+    void   endPaint() override;
+
+    size_t pushState() override;
+    void   popState(size_t id) override;
+
+    void   setState(const TexPtr& t, const Color& c, TextureFormat frm, ClampMode clamp) override;
+    void   setState(const Sprite& s, const Color& c) override;
+    void   setTopology(Topology t) override;
+    void   setBlend(const Blend b) override;
+    void   setDistanceField(bool df) override;
+    bool   setScissor(const Rect& sc) override;
+
+    struct Texture {
+      Sprite sprite;
+
+      bool operator==(const Texture& t) const {
+        return sprite.pageId()==t.sprite.pageId();
+        }
+      };
+
+    struct State {
+      Topology tp      = Triangles;
+      Blend    blend   = NoBlend;
+      bool     dField  = false;
+      Texture  tex;
+      bool     hasScissor = false;
+      Rect     scissor;
+
+      bool operator == (const State& s) const {
+        return tp==s.tp && blend==s.blend && dField==s.dField && tex==s.tex &&
+               hasScissor==s.hasScissor && scissor==s.scissor;
+        }
+      };
+
+    struct Block : State {
+      Block()=default;
+      Block(const State& s):State(s){}
+
+      size_t begin = 0;
+      size_t size  = 0;
+      };
+
+    struct Info {
+      uint32_t w=0,h=0;
+      };
+
+    std::vector<State> stateStk;
+    std::vector<Block> blocks;
+    std::vector<Point> buf;
+
+    Pixmap             out;
+    Info               info;
+    size_t             paintScope = 0;
+    uint32_t           threads    = 0;
+
+    void               resetBlocks();
+    void               rasterize();
+
+    template<class T,T State::*param>
+    void setState(const T& t);
+  };
+}
@@ -3,6 +3,14 @@
 #include <cmath>
 #include <cstring>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#include <emmintrin.h>
+#define T_TRANSFORM_SSE2 1
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define T_TRANSFORM_NEON 1
+#endif
+
 #define KD_FLT_EPSILON 1.19209290E-07F
 #define KD_DEG_TO_RAD_F 0.0174532924F
 
@@ -71,6 +79,76 @@ void Transform::scale(const float x, const float y) {
   invalidateType();
   }
 
+Transform Transform::operator * (const Transform& t) const {
+  Transform r;
+  for(int i=0;i<3;++i)
+    for(int j=0;j<3;++j)
+      r.v[i][j] = v[i][0]*t.v[0][j] + v[i][1]*t.v[1][j] + v[i][2]*t.v[2][j];
+  r.invalidateType();
+  return r;
+  }
+
+void Transform::mapN(const float* xy, float* out, size_t n) const {
+  if(tp==T_None) {
+    for(size_t i=0; i<n; ++i, xy+=2, out+=2)
+      map(xy[0],xy[1],out[0],out[1]);
+    return;
+    }
+
+  // affine: w is constant, fold it into coefficients
+  const float k  = 1.f/v[2][2];
+  const float a  = v[0][0]*k, b = v[0][1]*k;
+  const float c  = v[1][0]*k, d = v[1][1]*k;
+  const float e  = v[2][0]*k, f = v[2][1]*k;
+  const bool  sc = (tp==T_AxisAligned && b==0.f && c==0.f);
+
+  size_t i = 0;
+#if defined(T_TRANSFORM_SSE2)
+  const __m128 off = _mm_setr_ps(e,f,e,f);
+  if(sc) {
+    const __m128 mul = _mm_setr_ps(a,d,a,d);
+    for(; i+2<=n; i+=2) {
+      __m128 p = _mm_loadu_ps(xy+i*2);
+      _mm_storeu_ps(out+i*2,_mm_add_ps(_mm_mul_ps(p,mul),off));
+      }
+    } else {
+    const __m128 mx = _mm_setr_ps(a,b,a,b);
+    const __m128 my = _mm_setr_ps(c,d,c,d);
+    for(; i+2<=n; i+=2) {
+      __m128 p  = _mm_loadu_ps(xy+i*2);
+      __m128 px = _mm_shuffle_ps(p,p,_MM_SHUFFLE(2,2,0,0));
+      __m128 py = _mm_shuffle_ps(p,p,_MM_SHUFFLE(3,3,1,1));
+      _mm_storeu_ps(out+i*2,_mm_add_ps(_mm_add_ps(_mm_mul_ps(px,mx),_mm_mul_ps(py,my)),off));
+      }
+    }
+#elif defined(T_TRANSFORM_NEON)
+  const float       cf[4][4] = {{a,d,a,d},{a,b,a,b},{c,d,c,d},{e,f,e,f}};
+  const float32x4_t off      = vld1q_f32(cf[3]);
+  if(sc) {
+    const float32x4_t mul = vld1q_f32(cf[0]);
+    for(; i+2<=n; i+=2) {
+      float32x4_t p = vld1q_f32(xy+i*2);
+      vst1q_f32(out+i*2,vmlaq_f32(off,p,mul));
+      }
+    } else {
+    const float32x4_t mx = vld1q_f32(cf[1]);
+    const float32x4_t my = vld1q_f32(cf[2]);
+    for(; i+2<=n; i+=2) {
+      float32x2x2_t q  = vld2_f32(xy+i*2); // {x0,x1},{y0,y1}
+      float32x4_t   px = vcombine_f32(vdup_lane_f32(q.val[0],0),vdup_lane_f32(q.val[0],1));
+      float32x4_t   py = vcombine_f32(vdup_lane_f32(q.val[1],0),vdup_lane_f32(q.val[1],1));
+      vst1q_f32(out+i*2,vmlaq_f32(vmlaq_f32(off,px,mx),py,my));
+      }
+    }
+#endif
+
+  for(; i<n; ++i) {
+    const float x = xy[i*2+0], y = xy[i*2+1];
+    out[i*2+0] = a*x + c*y + e;
+    out[i*2+1] = b*x + d*y + f;
+    }
+  }
+
 const Transform &Transform::identity() {
   static Transform tr(1,0,0,
                       0,1,0,
@@ -81,7 +159,9 @@ const Transform &Transform::identity() {
 void Transform::invalidateType() {
   if((v[0][1]==0.f && v[0][2]==0.f && v[1][0]==0.f && v[1][2]==0.f) ||
      (v[0][0]==0.f && v[0][2]==0.f && v[1][1]==0.f && v[1][2]==0.f))
-    tp = T_AxisAligned; else
+    tp = T_AxisAligned;
+  else if(v[0][2]==0.f && v[1][2]==0.f)
+    tp = T_Affine; else
     tp = T_None;
 
   scaleHH = std::sqrt(v[0][0]*v[0][0] + v[0][1]*v[0][1]);
@@ -13,12 +13,18 @@ class Transform final {
 
     enum   Type : uint8_t {
       T_AxisAligned,
-      T_None
+      T_None,
+      T_Affine
       };
 
     void   map(float x,float y,float& outX,float& outY) const;
     void   map(int   x,int   y,int&   outX,int&   outY) const;
     PointF map(const Point& p) const { PointF r; map(float(p.x),float(p.y),r.x,r.y); return r; }
+    // maps n interleaved xy pairs; in-place mapping (xy==out) is allowed
+    void   mapN(const float* xy, float* out, size_t n) const;
+
+    // result maps through *this first, then through t
+    Transform operator * (const Transform& t) const;
 
     void   translate(float x,float y);
     void   translate(const Point& p);
@@ -5,12 +5,76 @@
 #include <Tempest/Painter>
 #include <Tempest/Event>
 #include <Tempest/Encoder>
+#include <Tempest/TextureAtlas>
+#include <Tempest/MemReader>
+#include <Tempest/MemWriter>
+#include <Tempest/Except>
+
+#include <unordered_map>
+#include <cmath>
+#include <cstring>
+#include <zlib.h>
 
 #define  NANOSVG_IMPLEMENTATION
 #include "thirdparty/nanosvg.h"
 
 using namespace Tempest;
 
+namespace {
+const char     magic[4] = {'T','V','I','M'};
+const uint32_t version  = 2;
+enum Flags : uint32_t {
+  F_Compressed = 1,
+  };
+
+template<class T>
+void write(ODevice& fout, const T& t) {
+  static_assert(std::is_trivially_copyable<T>::value);
+  if(fout.write(&t,sizeof(t))!=sizeof(t))
+    throw std::system_error(Tempest::SystemErrc::UnableToSaveAsset);
+  }
+
+template<class T>
+T read(IDevice& fin) {
+  static_assert(std::is_trivially_copyable<T>::value);
+  T t = {};
+  if(fin.read(&t,sizeof(t))!=sizeof(t))
+    throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+  return t;
+  }
+
+// push constants of polyline.vert
+struct LinePush {
+  float    invSize[2];
+  uint32_t begin, count;
+  uint32_t join, cap;
+  uint32_t aa;
+  };
+// body and two fans of join/cap patches per segment, see polyline.vert
+const size_t lineVertices = 12+9+9;
+
+// negative offset is not allowed by graphics api
+Rect scissorRect(const Rect& sc) {
+  return sc.intersected(Rect(0,0,sc.x+sc.w,sc.y+sc.h));
+  }
+
+uint64_t contentKey(const uint8_t* px, uint32_t w, uint32_t h) {
+  // FNV-1a
+  uint64_t k = 14695981039346656037ull;
+  auto mix = [&k](const void* d, size_t sz) {
+    auto b = reinterpret_cast<const uint8_t*>(d);
+    for(size_t i=0; i<sz; ++i) {
+      k ^= b[i];
+      k *= 1099511628211ull;
+      }
+    };
+  mix(&w,sizeof(w));
+  mix(&h,sizeof(h));
+  mix(px,size_t(w)*h*4);
+  return k;
+  }
+}
+
 void VectorImage::beginPaint(bool clr, uint32_t w, uint32_t h) {
   if(clr || blocks.size()==0)
     clear();
@@ -25,6 +89,7 @@ void VectorImage::endPaint() {
   paintScope--;
   if(paintScope!=0)
     return;
+  mergeBlocks();
   }
 
 size_t VectorImage::pushState() {
@@ -87,14 +152,105 @@ void VectorImage::setBlend(const Painter::Blend b) {
   setState<Painter::Blend,&State::blend>(b);
   }
 
+void VectorImage::setDistanceField(bool df) {
+  setState<bool,&State::dField>(df);
+  }
+
+bool VectorImage::setScissor(const Rect& sc) {
+  if(!hwScissor)
+    return false;
+  Scissor s;
+  s.enable = true;
+  s.rect   = scissorRect(sc);
+  setState<Scissor,&State::scissor>(s);
+  return true;
+  }
+
+bool VectorImage::addPolyline(const LinePoint* pt, size_t n, uint8_t join, uint8_t cap, const Rect& sc) {
+  if(n<2)
+    return true;
+
+  const State prev = blocks.back();
+  Line        ln;
+  ln.enable = true;
+  ln.join   = join;
+  ln.cap    = cap;
+  setState<Line,&State::line>(ln);
+  if(!hwScissor) {
+    // line geometry is never clipped on cpu
+    Scissor s;
+    s.enable = true;
+    s.rect   = scissorRect(sc);
+    setState<Scissor,&State::scissor>(s);
+    }
+
+  if(blocks.size()>1 && blocks.back().size==0) {
+    // consecutive polylines: continue previous block instead of the empty one left by state restore
+    auto& pb = blocks[blocks.size()-2];
+    if(static_cast<const State&>(pb)==blocks.back() && pb.hasImg==blocks.back().hasImg)
+      blocks.pop_back();
+    }
+
+  auto& b = blocks.back();
+  if(b.size==0)
+    b.begin = lines.size(); else
+    lines.emplace_back();
+  lines.insert(lines.end(),pt,pt+n);
+  b.size = lines.size()-b.begin;
+
+  setState<Line,&State::line>(prev.line);
+  setState<Scissor,&State::scissor>(prev.scissor);
+  return true;
+  }
+
+void VectorImage::setHardwareScissor(bool hw) {
+  hwScissor = hw;
+  if(!hw && !blocks.empty())
+    setState<Scissor,&State::scissor>(Scissor());
+  }
+
 void VectorImage::clear() {
   buf.clear();
+  lines.clear();
   blocks.resize(1);
   blocks.back()=Block();
   stateStk.clear();
   slock.clear();
   }
 
+void VectorImage::append(const VectorImage& frag) {
+  if(blocks.empty()) {
+    // never painted: start from default state
+    blocks.emplace_back();
+    blocks.back().begin = buf.size();
+    }
+  const State  last   = blocks.back();
+  const bool   hasImg = blocks.back().hasImg;
+  const size_t offset = buf.size();
+  const size_t lnOff  = lines.size();
+
+  buf.insert(buf.end(),frag.buf.begin(),frag.buf.end());
+  lines.insert(lines.end(),frag.lines.begin(),frag.lines.end());
+  for(auto& b:frag.blocks) {
+    if(b.size==0)
+      continue;
+    if(blocks.back().size==0)
+      blocks.pop_back();
+    blocks.push_back(b);
+    blocks.back().begin += (b.line.enable ? lnOff : offset);
+    }
+  for(auto& s:frag.slock.spr)
+    slock.insert(s);
+
+  if(!(static_cast<const State&>(blocks.back())==last) || blocks.back().size!=0) {
+    blocks.emplace_back(last);
+    blocks.back().begin  = buf.size();
+    blocks.back().hasImg = hasImg;
+    }
+  if(paintScope==0)
+    mergeBlocks();
+  }
+
 void VectorImage::addPoint(const PaintDevice::Point &p) {
   buf.push_back(p);
   blocks.back().size++;
@@ -110,10 +266,167 @@ void VectorImage::commitPoints() {
     }
   }
 
+void VectorImage::mergeBlocks() {
+  // how far back a block may travel and how many members of group are tested precisely, to keep pass linear
+  static constexpr size_t maxLookback = 64;
+  static constexpr size_t maxMembers  = 32;
+
+  struct Bounds {
+    float x0,y0,x1,y1;
+    bool  overlaps(const Bounds& b) const {
+      return x0<=b.x1 && b.x0<=x1 && y0<=b.y1 && b.y0<=y1;
+      }
+    void  join(const Bounds& b) {
+      x0 = std::min(x0,b.x0);
+      y0 = std::min(y0,b.y0);
+      x1 = std::max(x1,b.x1);
+      y1 = std::max(y1,b.y1);
+      }
+    };
+
+  struct Group {
+    size_t head, tail;
+    size_t size;
+    size_t count;
+    Bounds bbox;
+    };
+
+  if(blocks.size()<3)
+    return;
+
+  const State           last = blocks.back();
+  std::vector<Group>    group;
+  std::vector<size_t>   next(blocks.size(),size_t(-1));
+  std::vector<Bounds>   bounds(blocks.size());
+  group.reserve(blocks.size());
+
+  auto overlaps = [&](const Group& g, const Bounds& bb) {
+    if(!g.bbox.overlaps(bb))
+      return false;
+    if(g.count>maxMembers)
+      return true;
+    for(size_t i=g.head; i!=size_t(-1); i=next[i])
+      if(bounds[i].overlaps(bb))
+        return true;
+    return false;
+    };
+
+  for(size_t i=0; i<blocks.size(); ++i) {
+    auto& b = blocks[i];
+    if(b.size==0)
+      continue;
+
+    Bounds bb = {};
+    if(b.line.enable) {
+      // in pixels, miter joins may reach out by 4 half-widths
+      bb = {lines[b.begin].x, lines[b.begin].y, lines[b.begin].x, lines[b.begin].y};
+      for(size_t r=b.begin; r<b.begin+b.size; ++r) {
+        auto& l = lines[r];
+        const float ext = l.width*2.f+1.f;
+        if(l.width<=0.f)
+          continue;
+        bb.x0 = std::min(bb.x0,l.x-ext);
+        bb.y0 = std::min(bb.y0,l.y-ext);
+        bb.x1 = std::max(bb.x1,l.x+ext);
+        bb.y1 = std::max(bb.y1,l.y+ext);
+        }
+      const float invW = 2.f/float(std::max(info.w,1u)), invH = 2.f/float(std::max(info.h,1u));
+      bb = {bb.x0*invW-1.f, bb.y0*invH-1.f, bb.x1*invW-1.f, bb.y1*invH-1.f};
+      } else {
+      bb = {buf[b.begin].x, buf[b.begin].y, buf[b.begin].x, buf[b.begin].y};
+      for(size_t r=b.begin+1; r<b.begin+b.size; ++r) {
+        bb.x0 = std::min(bb.x0,buf[r].x);
+        bb.y0 = std::min(bb.y0,buf[r].y);
+        bb.x1 = std::max(bb.x1,buf[r].x);
+        bb.y1 = std::max(bb.y1,buf[r].y);
+        }
+      }
+    bounds[i] = bb;
+
+    // move block back to the nearest group with same state, if nothing drawn in between overlaps it
+    bool merged = false;
+    for(size_t j=group.size(), n=0; j>0 && n<maxLookback; ++n) {
+      --j;
+      auto& g = group[j];
+      auto& s = blocks[g.head];
+      if(static_cast<const State&>(s)==b && s.hasImg==b.hasImg) {
+        next[g.tail] = i;
+        g.tail  = i;
+        g.size += b.size;
+        g.count++;
+        g.bbox.join(bb);
+        merged  = true;
+        break;
+        }
+      if(overlaps(g,bb))
+        break;
+      }
+    if(!merged)
+      group.push_back(Group{i,i,b.size,1,bb});
+    }
+
+  if(group.size()+1>=blocks.size())
+    return;
+
+  std::vector<Point>     nbuf;
+  std::vector<LinePoint> nlines;
+  std::vector<Block>     nblk;
+  nbuf.reserve(buf.size());
+  nlines.reserve(lines.size());
+  nblk.reserve(group.size()+1);
+  for(auto& g:group) {
+    Block b = blocks[g.head];
+    if(b.line.enable) {
+      b.begin = nlines.size();
+      for(size_t i=g.head; i!=size_t(-1); i=next[i]) {
+        auto& src = blocks[i];
+        if(nlines.size()>b.begin)
+          nlines.emplace_back();
+        nlines.insert(nlines.end(),lines.begin()+ptrdiff_t(src.begin),lines.begin()+ptrdiff_t(src.begin+src.size));
+        }
+      b.size = nlines.size()-b.begin;
+      } else {
+      b.begin = nbuf.size();
+      b.size  = g.size;
+      for(size_t i=g.head; i!=size_t(-1); i=next[i]) {
+        auto& src = blocks[i];
+        nbuf.insert(nbuf.end(),buf.begin()+ptrdiff_t(src.begin),buf.begin()+ptrdiff_t(src.begin+src.size));
+        }
+      }
+    nblk.push_back(std::move(b));
+    }
+
+  // keep current state for subsequent painting
+  if(nblk.empty() || !(static_cast<const State&>(nblk.back())==last)) {
+    Block b(last);
+    b.begin  = nbuf.size();
+    b.hasImg = blocks.back().hasImg;
+    nblk.push_back(std::move(b));
+    }
+
+  buf    = std::move(nbuf);
+  lines  = std::move(nlines);
+  blocks = std::move(nblk);
+  }
+
 const RenderPipeline& VectorImage::pipelineOf(Device& dev, const VectorImage::Block& b) const {
   const RenderPipeline* p;
-  if(b.hasImg) {
-    if(b.tp==Triangles){
+  if(b.line.enable) {
+    if(b.blend==NoBlend)
+      p=&dev.builtin().polyline().brush; else
+    if(b.blend==Alpha)
+      p=&dev.builtin().polyline().brushB; else
+      p=&dev.builtin().polyline().brushA;
+    }
+  else if(b.hasImg) {
+    if(b.tp==Triangles && b.dField){
+      if(b.blend==NoBlend)
+        p=&dev.builtin().distanceField().brush; else
+      if(b.blend==Alpha)
+        p=&dev.builtin().distanceField().brushB; else
+        p=&dev.builtin().distanceField().brushA;
+      }
+    else if(b.tp==Triangles){
       if(b.blend==NoBlend)
         p=&dev.builtin().texture2d().brush; else
       if(b.blend==Alpha)
@@ -173,20 +486,298 @@ bool VectorImage::load(const char *file) {
   return true;
   }
 
+void VectorImage::save(ODevice& fout, bool compress) const {
+  struct Image {
+    uint64_t             key = 0;
+    uint32_t             w = 0, h = 0;
+    std::vector<uint8_t> px;
+    };
+  std::vector<Image>                   img;
+  std::unordered_map<uint64_t,int32_t> imgId;
+  std::vector<Point>                   pt = buf;
+
+  std::vector<uint8_t> payload;
+  MemWriter            mem(payload);
+
+  write(mem,uint32_t(blocks.size()));
+  std::vector<int32_t> blockImg(blocks.size(),-1);
+
+  for(size_t i=0; i<blocks.size(); ++i) {
+    auto& b = blocks[i];
+    if(!b.hasImg || b.size==0)
+      continue;
+    if(b.tex.brush)
+      throw std::system_error(Tempest::SystemErrc::UnableToSaveAsset); // gpu-only texture
+    auto&  page = b.tex.sprite.pagePixmap();
+    if(page.isEmpty())
+      continue;
+
+    // block may reference multiple sprites of same page (glyphs): store texel bounds of all uv's
+    const int pw = int(page.w()), ph = int(page.h());
+    float u0 = 1, v0 = 1, u1 = 0, v1 = 0;
+    for(size_t r=b.begin; r<b.begin+b.size; ++r) {
+      u0 = std::min(u0,buf[r].u);
+      v0 = std::min(v0,buf[r].v);
+      u1 = std::max(u1,buf[r].u);
+      v1 = std::max(v1,buf[r].v);
+      }
+    // one texel border for linear filtering
+    const int x0 = std::clamp(int(std::floor(u0*float(pw)))-1,0,pw);
+    const int y0 = std::clamp(int(std::floor(v0*float(ph)))-1,0,ph);
+    const int x1 = std::clamp(int(std::ceil (u1*float(pw)))+1,0,pw);
+    const int y1 = std::clamp(int(std::ceil (v1*float(ph)))+1,0,ph);
+    if(x0>=x1 || y0>=y1)
+      continue;
+
+    Image im;
+    im.w = uint32_t(x1-x0);
+    im.h = uint32_t(y1-y0);
+    im.px.resize(size_t(im.w)*im.h*4);
+    auto src = reinterpret_cast<const uint8_t*>(page.data());
+    if(page.format()==TextureFormat::R8) {
+      // glyph coverage page: stored as white with alpha, same as it's sampled
+      for(uint32_t y=0; y<im.h; ++y) {
+        auto s = src+size_t(y0+int(y))*size_t(pw)+size_t(x0);
+        auto d = &im.px[size_t(y)*im.w*4];
+        for(uint32_t x=0; x<im.w; ++x) {
+          d[x*4+0] = 255;
+          d[x*4+1] = 255;
+          d[x*4+2] = 255;
+          d[x*4+3] = s[x];
+          }
+        }
+      } else {
+      for(uint32_t y=0; y<im.h; ++y)
+        std::memcpy(&im.px[size_t(y)*im.w*4], src+(size_t(y0+int(y))*size_t(pw)+size_t(x0))*4, im.w*4);
+      }
+    im.key = contentKey(im.px.data(),im.w,im.h);
+
+    for(size_t r=b.begin; r<b.begin+b.size; ++r) {
+      pt[r].u = (pt[r].u*float(pw)-float(x0))/float(im.w);
+      pt[r].v = (pt[r].v*float(ph)-float(y0))/float(im.h);
+      }
+
+    auto it = imgId.find(im.key);
+    if(it!=imgId.end()) {
+      blockImg[i] = it->second;
+      continue;
+      }
+    blockImg[i] = int32_t(img.size());
+    imgId[im.key] = blockImg[i];
+    img.push_back(std::move(im));
+    }
+
+  for(size_t i=0; i<blocks.size(); ++i) {
+    auto& b = blocks[i];
+    write(mem,uint8_t(b.tp));
+    write(mem,uint8_t(b.blend));
+    write(mem,uint8_t(b.dField));
+    write(mem,uint8_t(b.scissor.enable));
+    write(mem,b.scissor.rect);
+    write(mem,uint8_t(b.line.enable));
+    write(mem,b.line.join);
+    write(mem,b.line.cap);
+    write(mem,blockImg[i]);
+    write(mem,uint64_t(b.begin));
+    write(mem,uint64_t(b.size));
+    }
+
+  write(mem,uint32_t(img.size()));
+  for(auto& i:img) {
+    write(mem,i.key);
+    write(mem,i.w);
+    write(mem,i.h);
+    if(mem.write(i.px.data(),i.px.size())!=i.px.size())
+      throw std::system_error(Tempest::SystemErrc::UnableToSaveAsset);
+    }
+
+  write(mem,uint64_t(pt.size()));
+  if(mem.write(pt.data(),pt.size()*sizeof(Point))!=pt.size()*sizeof(Point))
+    throw std::system_error(Tempest::SystemErrc::UnableToSaveAsset);
+
+  write(mem,uint64_t(lines.size()));
+  if(mem.write(lines.data(),lines.size()*sizeof(LinePoint))!=lines.size()*sizeof(LinePoint))
+    throw std::system_error(Tempest::SystemErrc::UnableToSaveAsset);
+
+  const uint64_t rawSize = payload.size();
+  if(compress) {
+    std::vector<uint8_t> z(compressBound(uLong(payload.size())));
+    uLongf               zsize = uLongf(z.size());
+    if(compress2(z.data(),&zsize,payload.data(),uLong(payload.size()),Z_DEFAULT_COMPRESSION)!=Z_OK)
+      throw std::system_error(Tempest::SystemErrc::UnableToSaveAsset);
+    z.resize(zsize);
+    std::swap(z,payload);
+    }
+
+  write(fout,magic);
+  write(fout,version);
+  write(fout,uint32_t(compress ? F_Compressed : 0));
+  write(fout,info.w);
+  write(fout,info.h);
+  if(compress)
+    write(fout,rawSize);
+  write(fout,uint64_t(payload.size()));
+  if(fout.write(payload.data(),payload.size())!=payload.size())
+    throw std::system_error(Tempest::SystemErrc::UnableToSaveAsset);
+  }
+
+void VectorImage::load(IDevice& fin, TextureAtlas& atlas) {
+  char mg[4] = {};
+  if(fin.read(mg,4)!=4 || std::memcmp(mg,magic,4)!=0)
+    throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+  // version 1 has no polylines
+  const uint32_t ver = read<uint32_t>(fin);
+  if(ver<1 || ver>version)
+    throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+
+  const uint32_t flags = read<uint32_t>(fin);
+  Info           inf;
+  inf.w = read<uint32_t>(fin);
+  inf.h = read<uint32_t>(fin);
+
+  uint64_t rawSize = 0;
+  if(flags & F_Compressed)
+    rawSize = read<uint64_t>(fin);
+  const uint64_t size = read<uint64_t>(fin);
+  if(size>fin.size())
+    throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+
+  std::vector<uint8_t> payload(size);
+  if(fin.read(payload.data(),payload.size())!=payload.size())
+    throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+  if(flags & F_Compressed) {
+    // deflate can't compress better than 1032:1 - bigger rawSize is corrupt, not a reason for bad_alloc
+    if(rawSize>size*1032+64)
+      throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+    std::vector<uint8_t> raw(rawSize);
+    uLongf               rsize = uLongf(raw.size());
+    if(uncompress(raw.data(),&rsize,payload.data(),uLong(payload.size()))!=Z_OK || rsize!=raw.size())
+      throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+    std::swap(raw,payload);
+    }
+
+  MemReader mem(payload);
+  // every count is bounded by what is left in payload, before anything is allocated for it
+  auto count = [&mem](size_t elementSize) {
+    const uint64_t n = read<uint64_t>(mem);
+    if(n>(mem.size()-mem.cursorPosition())/elementSize)
+      throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+    return size_t(n);
+    };
+
+  const size_t blockSize = 4+sizeof(Rect)+(ver>=2 ? 3 : 0)+sizeof(int32_t)+2*sizeof(uint64_t);
+  const size_t blkCount  = read<uint32_t>(mem);
+  if(blkCount>(mem.size()-mem.cursorPosition())/blockSize)
+    throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+
+  std::vector<Block>   blk(blkCount);
+  std::vector<int32_t> blockImg(blk.size());
+  for(size_t i=0; i<blk.size(); ++i) {
+    auto& b = blk[i];
+    const uint8_t tp    = read<uint8_t>(mem);
+    const uint8_t blend = read<uint8_t>(mem);
+    if((tp!=Lines && tp!=Triangles) || blend>Add)
+      throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+    b.tp             = Topology(tp);
+    b.blend          = Blend(blend);
+    b.dField         = read<uint8_t>(mem)!=0;
+    b.scissor.enable = read<uint8_t>(mem)!=0;
+    b.scissor.rect   = read<Rect>(mem);
+    if(ver>=2) {
+      b.line.enable  = read<uint8_t>(mem)!=0;
+      b.line.join    = read<uint8_t>(mem);
+      b.line.cap     = read<uint8_t>(mem);
+      if(b.line.join>Pen::RoundJoin || b.line.cap>Pen::RoundCap)
+        throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+      }
+    blockImg[i]      = read<int32_t>(mem);
+    b.begin          = size_t(read<uint64_t>(mem));
+    b.size           = size_t(read<uint64_t>(mem));
+    }
+
+  const size_t sprCount = read<uint32_t>(mem);
+  if(sprCount>(mem.size()-mem.cursorPosition())/(sizeof(uint64_t)+2*sizeof(uint32_t)))
+    throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+  std::vector<Sprite> spr(sprCount);
+  for(auto& s:spr) {
+    read<uint64_t>(mem);
+    const uint32_t w = read<uint32_t>(mem);
+    const uint32_t h = read<uint32_t>(mem);
+    if(w==0 || h==0 || uint64_t(w)*h>(mem.size()-mem.cursorPosition())/4)
+      throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+    const size_t   sz = size_t(w)*h*4;
+    s = atlas.load(payload.data()+mem.cursorPosition(),w,h,TextureFormat::RGBA8);
+    if(mem.seek(sz)!=sz)
+      throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+    }
+
+  std::vector<Point> pt(count(sizeof(Point)));
+  if(mem.read(pt.data(),pt.size()*sizeof(Point))!=pt.size()*sizeof(Point))
+    throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+
+  std::vector<LinePoint> ln;
+  if(ver>=2) {
+    ln.resize(count(sizeof(LinePoint)));
+    if(mem.read(ln.data(),ln.size()*sizeof(LinePoint))!=ln.size()*sizeof(LinePoint))
+      throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+    }
+
+  SpriteLock lck;
+  for(size_t i=0; i<blk.size(); ++i) {
+    auto& b = blk[i];
+    const size_t n = (b.line.enable ? ln.size() : pt.size());
+    if(b.begin>n || b.size>n-b.begin || blockImg[i]>=int32_t(spr.size()))
+      throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+    if(blockImg[i]<0 || b.line.enable)
+      continue;
+
+    auto&      s = spr[size_t(blockImg[i])];
+    const Rect r = s.pageRect();
+    for(size_t p=b.begin; p<b.begin+b.size; ++p) {
+      pt[p].u = (float(r.x)+pt[p].u*float(s.w()))/float(r.w);
+      pt[p].v = (float(r.y)+pt[p].v*float(s.h()))/float(r.h);
+      }
+    b.tex.sprite = s;
+    b.hasImg     = true;
+    lck.insert(s);
+    }
+  if(blk.empty())
+    blk.resize(1);
+
+  info   = inf;
+  buf    = std::move(pt);
+  lines  = std::move(ln);
+  blocks = std::move(blk);
+  slock  = std::move(lck);
+  stateStk.clear();
+  }
 
 void VectorImage::Mesh::update(Device& dev, const VectorImage& src, BufferHeap heap) {
   if(vbo.size()==src.buf.size())
     vbo.update(src.buf); else
     vbo=dev.vbo(heap,src.buf);
+  if(!src.lines.empty()) {
+    if(ssbo.byteSize()==src.lines.size()*sizeof(LinePoint))
+      ssbo.update(src.lines); else
+      ssbo=dev.ssbo(heap,src.lines);
+    }
 
   blocks.resize(src.blocks.size());
+  sprites  = src.slock.spr;
+  viewport = Rect(0,0,int(src.w()),int(src.h()));
 
   for(size_t i=0;i<blocks.size();++i){
     auto& b  = src.blocks[i];
     auto& ux = blocks[i];
 
-    ux.begin = b.begin;
-    ux.size  = b.size;
+    ux.begin      = b.begin;
+    ux.size       = b.size;
+    ux.hasScissor = b.scissor.enable;
+    ux.scissor    = b.scissor.rect;
+    ux.line       = b.line.enable;
+    ux.join       = b.line.join;
+    ux.cap        = b.line.cap;
+    ux.aa         = (b.blend==Alpha);
 
     auto& p = src.pipelineOf(dev,b);
     if(ux.desc.isEmpty() || ux.pipeline!=&p){
@@ -194,6 +785,12 @@ void VectorImage::Mesh::update(Device& dev, const VectorImage& src, BufferHeap h
       ux.pipeline = &p;
       }
 
+    if(b.line.enable) {
+      if(b.size>0)
+        ux.desc.set(0,ssbo);
+      continue;
+      }
+
     if(T_LIKELY(b.hasImg)) {
       if(b.tex.brush) {
         Sampler s;
@@ -212,19 +809,52 @@ void VectorImage::Mesh::update(Device& dev, const VectorImage& src, BufferHeap h
         s.vClamp = b.tex.clamp;
         ux.desc.set(0,b.tex.brush,s);
         } else {
-        ux.desc.set(0,b.tex.sprite.pageRawData(dev)); //TODO: oom
-        ux.sprite = b.tex.sprite;
+        auto& t = b.tex.sprite.pageRawData(dev); //TODO: oom
+        if(b.tex.sprite.pagePixmap().format()==TextureFormat::R8) {
+          // glyph coverage page: white with alpha from the single channel
+          Sampler s = Sampler::anisotrophy();
+          s.mapping.r = ComponentSwizzle::One;
+          s.mapping.g = ComponentSwizzle::One;
+          s.mapping.b = ComponentSwizzle::One;
+          s.mapping.a = ComponentSwizzle::R;
+          ux.desc.set(0,t,s);
+          } else {
+          ux.desc.set(0,t);
+          }
         }
       }
     }
   }
 
 void VectorImage::Mesh::draw(Encoder<CommandBuffer>& cmd) const {
+  // block scissors are nested into caller's one, which is restored at the end
+  const Rect base = cmd.scissor();
+  Rect       sc   = base;
   for(size_t i=0;i<blocks.size();++i){
     auto& b = blocks[i];
     if(b.size==0)
       continue;
+    const Rect bs = b.hasScissor ? base.intersected(b.scissor) : base;
+    if(bs!=sc) {
+      cmd.setScissor(bs);
+      sc = bs;
+      }
+    if(b.line) {
+      LinePush push = {};
+      push.invSize[0] = 2.f/float(viewport.w);
+      push.invSize[1] = 2.f/float(viewport.h);
+      push.begin      = uint32_t(b.begin);
+      push.count      = uint32_t(b.size);
+      push.join       = b.join;
+      push.cap        = b.cap;
+      push.aa         = b.aa ? 1 : 0;
+      cmd.setUniforms(*b.pipeline,b.desc,&push,sizeof(push));
+      cmd.draw(nullptr,0,lineVertices,0,b.size-1);
+      continue;
+      }
     cmd.setUniforms(*b.pipeline,b.desc);
     cmd.draw(vbo,b.begin,b.size);
     }
+  if(sc!=base)
+    cmd.setScissor(base);
   }
@@ -2,6 +2,7 @@
 
 #include <Tempest/PaintDevice>
 #include <Tempest/VertexBuffer>
+#include <Tempest/StorageBuffer>
 #include <Tempest/DescriptorSet>
 #include <Tempest/Rect>
 #include <Tempest/Sprite>
@@ -13,6 +14,10 @@ namespace Tempest {
 template<class T>
 class Encoder;
 
+class IDevice;
+class ODevice;
+class TextureAtlas;
+
 class VectorImage : public Tempest::PaintDevice {
   public:
     VectorImage()=default;
@@ -20,6 +25,7 @@ class VectorImage : public Tempest::PaintDevice {
     class Mesh {
       public:
         void update(Device& dev, const VectorImage& src, BufferHeap heap = BufferHeap::Upload);
+        // recorded scissors are clipped by encoder current scissor, which is preserved
         void draw  (Encoder<CommandBuffer>& cmd) const;
 
       private:
@@ -29,11 +35,20 @@ class VectorImage : public Tempest::PaintDevice {
 
           DescriptorSet         desc;
           const RenderPipeline* pipeline = nullptr;
-          // strong reference to sprite
-          Sprite                sprite;
+          bool                  hasScissor = false;
+          Rect                  scissor;
+          // polyline block: push constants for line expansion shader
+          bool                  line = false;
+          uint8_t               join = 0;
+          uint8_t               cap  = 0;
+          bool                  aa   = false;
           };
         Tempest::VertexBuffer<Point> vbo;
+        Tempest::StorageBuffer       ssbo;
         std::vector<Block>           blocks;
+        // strong references to all sprites, baked into uv's: atlas must not move them while mesh is alive
+        std::vector<Sprite>          sprites;
+        Rect                         viewport;
       };
 
     uint32_t w() const { return info.w; }
@@ -42,6 +57,19 @@ class VectorImage : public Tempest::PaintDevice {
     bool     load(const char* path);
     void     clear() override;
 
+    // splice fragment painted separately (possibly on another thread, with same PaintEvent size) in paint order;
+    // must not be called while Painter is active on this image. Widget painting itself stays serial:
+    // splitting work into fragments is up to the caller
+    void     append(const VectorImage& fragment);
+
+    // binary display list; sprite pixels are stored once per content key and re-uploaded to atlas on load
+    void     save(ODevice& fout, bool compress = false) const;
+    void     load(IDevice& fin, TextureAtlas& atlas);
+
+    // record Painter scissor as block state and apply it with Encoder::setScissor, instead of clipping geometry
+    void     setHardwareScissor(bool hw);
+    bool     isHardwareScissor() const { return hwScissor; }
+
   private:
     void   addPoint(const Point& p) override;
     void   commitPoints() override;
@@ -56,6 +84,9 @@ class VectorImage : public Tempest::PaintDevice {
     void   setState(const Sprite& s, const Color& c) override;
     void   setTopology(Topology t) override;
     void   setBlend(const Blend b) override;
+    void   setDistanceField(bool df) override;
+    bool   setScissor(const Rect& sc) override;
+    bool   addPolyline(const LinePoint* pt, size_t n, uint8_t join, uint8_t cap, const Rect& sc) override;
 
     struct SpriteLock {
       std::vector<Sprite> spr;
@@ -84,13 +115,36 @@ class VectorImage : public Tempest::PaintDevice {
         }
       };
 
+    struct Scissor {
+      bool           enable = false;
+      Rect           rect;
+
+      bool operator == (const Scissor& s) const {
+        return enable==s.enable && rect==s.rect;
+        }
+      };
+
+    // block of polyline points, instead of triangles
+    struct Line {
+      bool           enable = false;
+      uint8_t        join   = 0;
+      uint8_t        cap    = 0;
+
+      bool operator == (const Line& l) const {
+        return enable==l.enable && join==l.join && cap==l.cap;
+        }
+      };
+
     struct State {
       Topology       tp    = Triangles;
       Blend          blend = NoBlend;
+      bool           dField = false;
       Texture        tex;
+      Scissor        scissor;
+      Line           line;
 
       bool operator == (const State& s) const {
-        return tp==s.tp && blend==s.blend && tex==s.tex;
+        return tp==s.tp && blend==s.blend && dField==s.dField && tex==s.tex && scissor==s.scissor && line==s.line;
         }
       };
 
@@ -102,16 +156,18 @@ class VectorImage : public Tempest::PaintDevice {
 
       Block& operator=(const Block&)=default;
 
-      size_t         begin  = 0;
+      size_t         begin  = 0; // offset in buf, or in lines for polyline block
       size_t         size   = 0;
       bool           hasImg = false;
       };
 
     Topology                    topology=Triangles;
+    bool                        hwScissor=false;
 
     std::vector<State>          stateStk;
     std::vector<Block>          blocks;
     std::vector<Point>          buf;
+    std::vector<LinePoint>      lines;
     SpriteLock                  slock;
 
     struct Info {
@@ -121,6 +177,7 @@ class VectorImage : public Tempest::PaintDevice {
     size_t paintScope = 0;
 
     const RenderPipeline& pipelineOf(Device& dev, const Block& b) const;
+    void                  mergeBlocks();
 
     template<class T,T State::*param>
     void setState(const T& t);
@@ -4,30 +4,88 @@
 #include <Tempest/Painter>
 #include <Tempest/Platform>
 #include <Tempest/Log>
+#include <Tempest/TextCodec>
+#include "../io/mappedfile.h"
 #include "../utility/utf8_helper.h"
 #include "thirdparty/stb_truetype.h"
 
 #include <unordered_map>
-#include <bitset>
+#include <unordered_set>
+#include <deque>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <cmath>
 #include <algorithm>
 
 #ifdef __WINDOWS__
 #include <Shlobj.h>
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#include <emmintrin.h>
+#define T_FONT_SSE2 1
+#endif
+
 using namespace Tempest;
 
 namespace Tempest {
 namespace Detail {
-  template<size_t lvl>
-  struct Bucket {
-    std::unique_ptr<Bucket<lvl-1>> next[256];
-    };
+  // process-wide pool for background glyph rasterization
+  class GlyphWorkers final {
+    public:
+      GlyphWorkers() {
+        const uint32_t hc = std::thread::hardware_concurrency();
+        const uint32_t n  = hc>1 ? hc-1 : 1;
+        for(uint32_t i=0;i<n;++i)
+          th.emplace_back([this](){ run(); });
+        }
+
+      ~GlyphWorkers() {
+        {
+        std::lock_guard<std::mutex> guard(sync);
+        stop = true;
+        }
+        cv.notify_all();
+        for(auto& i:th)
+          i.join();
+        }
+
+      static GlyphWorkers& inst() {
+        static GlyphWorkers w;
+        return w;
+        }
+
+      void push(std::function<void()> fn) {
+        {
+        std::lock_guard<std::mutex> guard(sync);
+        queue.emplace_back(std::move(fn));
+        }
+        cv.notify_one();
+        }
 
-  template<>
-  struct Bucket<1> {
-    FontElement::Letter     letter[256];
-    std::bitset<256>        ex;
+    private:
+      void run() {
+        while(true) {
+          std::function<void()> fn;
+          {
+          std::unique_lock<std::mutex> guard(sync);
+          cv.wait(guard,[this](){ return stop || !queue.empty(); });
+          if(stop)
+            return;
+          fn = std::move(queue.front());
+          queue.pop_front();
+          }
+          fn();
+          }
+        }
+
+      std::mutex                        sync;
+      std::condition_variable           cv;
+      std::deque<std::function<void()>> queue;
+      std::vector<std::thread>          th;
+      bool                              stop = false;
     };
 
   static std::string getFontFolderPath() {
@@ -51,117 +109,360 @@ namespace Detail {
 
 }
 
+// open-addressing hash on (size, codepoint) with optional LRU eviction
 struct FontElement::LetterTable {
-  struct Chunk {
-    uint32_t          size=0;
-    Detail::Bucket<3> next[256];
+  static constexpr uint32_t Empty = uint32_t(-1);
+
+  struct Entry {
+    Letter   letter;
+    uint64_t key  = 0;
+    uint32_t prev = Empty; // LRU list, head is most recently used
+    uint32_t next = Empty;
     };
 
-  std::vector<Chunk> chunk;
+  struct Slot {
+    uint64_t key = 0;
+    uint32_t id  = Empty;
+    };
+
+  // deque: letters are returned by reference and must not move
+  std::deque<Entry>     entry;
+  std::vector<uint32_t> freeId;
+  std::vector<Slot>     slot;
+  uint32_t              shift  = 64;
+  size_t                count  = 0;
+  uint32_t              head   = Empty;
+  uint32_t              tail   = Empty;
+  size_t                budget = 0;
+
+  size_t                hits      = 0;
+  size_t                misses    = 0;
+  size_t                evictions = 0;
+
+  static uint64_t key(float sz,char32_t ch) {
+    return (uint64_t(uint32_t(sz*100))<<32) | uint64_t(ch);
+    }
+
+  size_t home(uint64_t k) const {
+    return size_t((k*0x9E3779B97F4A7C15ull) >> shift);
+    }
 
   Letter& at(float sz,char32_t ch){
-    return *implFind(sz,ch,true);
+    const uint64_t k = key(sz,ch);
+    if(auto id = implFind(k); id!=Empty) {
+      touch(id);
+      return entry[id].letter;
+      }
+    return entry[insert(k)].letter;
     }
 
   Letter* find(float sz,char32_t ch){
-    return implFind(sz,ch,false);
+    auto id = implFind(key(sz,ch));
+    if(id==Empty)
+      return nullptr;
+    touch(id);
+    return &entry[id].letter;
     }
 
-  Letter* implFind(float sz,char32_t ch,bool create){
-    uint32_t size = uint32_t(sz*100);
+  void setBudget(size_t b) {
+    budget = b;
+    trim();
+    }
 
-    for(auto& i:chunk)
-      if(i.size==size)
-        return implFind(i,uint32_t(ch),create);
+  // evicts over budget; only on thread, that requests letters: references handed out by
+  // letter() must not be dropped by background inserts
+  void trim() {
+    while(budget>0 && count>budget)
+      evict();
+    }
 
-    chunk.emplace_back();
-    chunk.back().size=size;
-    return implFind(chunk.back(),uint32_t(ch),create);
+  size_t memoryUsage() const {
+    return entry.size()*sizeof(Entry) + slot.capacity()*sizeof(Slot) + freeId.capacity()*sizeof(uint32_t);
     }
 
-  Letter* implFind(Chunk& c,uint32_t ch,bool create){
-    uint8_t* key = reinterpret_cast<uint8_t*>(&ch);
-    auto&    b   = c.next[*key];
-    return implFind(b,key+1,create);
+  uint32_t implFind(uint64_t k) const {
+    if(slot.empty())
+      return Empty;
+    const size_t mask = slot.size()-1;
+    for(size_t i=home(k); slot[i].id!=Empty; i=(i+1)&mask)
+      if(slot[i].key==k)
+        return slot[i].id;
+    return Empty;
     }
 
-  template<size_t lvl>
-  Letter* implFind(Detail::Bucket<lvl>& b,const uint8_t* k,bool create){
-    auto& ptr = b.next[*k];
-    if(ptr==nullptr && create)
-      ptr.reset(new Detail::Bucket<lvl-1>());
-    if(ptr==nullptr)
-      return nullptr;
-    return implFind(*b.next[*k],k+1,create);
+  uint32_t insert(uint64_t k) {
+    if((count+1)*4>slot.size()*3)
+      rehash(std::max<size_t>(64,slot.size()*2));
+
+    uint32_t id = Empty;
+    if(!freeId.empty()) {
+      id = freeId.back();
+      freeId.pop_back();
+      } else {
+      id = uint32_t(entry.size());
+      entry.emplace_back();
+      }
+    entry[id].key = k;
+    link(id);
+
+    const size_t mask = slot.size()-1;
+    size_t i = home(k);
+    while(slot[i].id!=Empty)
+      i = (i+1)&mask;
+    slot[i].key = k;
+    slot[i].id  = id;
+    ++count;
+    return id;
+    }
+
+  void rehash(size_t sz) {
+    std::vector<Slot> prev = std::move(slot);
+    slot.assign(sz,Slot());
+    shift = 64;
+    while((size_t(1)<<(64-shift))<sz)
+      --shift;
+
+    const size_t mask = sz-1;
+    for(auto& s:prev) {
+      if(s.id==Empty)
+        continue;
+      size_t i = home(s.key);
+      while(slot[i].id!=Empty)
+        i = (i+1)&mask;
+      slot[i] = s;
+      }
+    }
+
+  void evict() {
+    const uint32_t id = tail;
+    if(id==Empty)
+      return;
+    erase(entry[id].key);
+    unlink(id);
+    // drops the atlas sprite as well
+    entry[id].letter = Letter();
+    freeId.push_back(id);
+    --count;
+    ++evictions;
     }
 
-  Letter* implFind(Detail::Bucket<1>& b,const uint8_t* pk,bool create){
-    auto k = *pk;
-    if(!b.ex[k]){
-      if(create){
-        b.ex[k]=true;
-        return &b.letter[k];
+  void erase(uint64_t k) {
+    const size_t mask = slot.size()-1;
+    size_t i = home(k);
+    while(slot[i].key!=k || slot[i].id==Empty)
+      i = (i+1)&mask;
+
+    // backward shift deletion, keeps probe chains without tombstones
+    for(size_t j=i;;) {
+      slot[i].id = Empty;
+      for(;;) {
+        j = (j+1)&mask;
+        if(slot[j].id==Empty)
+          return;
+        const size_t h = home(slot[j].key);
+        if(i<=j ? (i<h && h<=j) : (i<h || h<=j))
+          continue;
+        slot[i] = slot[j];
+        i = j;
+        break;
         }
-      return nullptr;
       }
-    return &b.letter[k];
+    }
+
+  void touch(uint32_t id) {
+    if(head==id)
+      return;
+    unlink(id);
+    link(id);
+    }
+
+  void link(uint32_t id) {
+    auto& e = entry[id];
+    e.prev = Empty;
+    e.next = head;
+    if(head!=Empty)
+      entry[head].prev = id;
+    head = id;
+    if(tail==Empty)
+      tail = id;
+    }
+
+  void unlink(uint32_t id) {
+    auto& e = entry[id];
+    if(e.prev!=Empty)
+      entry[e.prev].next = e.next; else
+      head = e.next;
+    if(e.next!=Empty)
+      entry[e.next].prev = e.prev; else
+      tail = e.prev;
+    e.prev = Empty;
+    e.next = Empty;
     }
   };
 
-struct FontElement::Impl {
+struct FontElement::Impl : std::enable_shared_from_this<FontElement::Impl> {
   enum { MIN_BUF_SZ=512 };
+  // distance-field glyphs are rasterized once at reference size and scaled for any other size
+  enum { DF_REF_SIZE=48, DF_PADDING=6, DF_ONEDGE=128 };
+  // miss in alphabetic scripts prefetches the rest of aligned codepoint block
+  enum { LOOK_AHEAD_BLOCK=32, LOOK_AHEAD_END=0x2E80 };
+  // dense metric tables cover BMP, filled by blocks of codepoints on first use
+  enum { DENSE_BLOCK=256, DENSE_BLOCKS=0x10000/DENSE_BLOCK, DENSE_SIZES=16 };
+
+  struct DistanceField {
+    Sprite view;
+    int    w=0, h=0;
+    int    dx=0,dy=0;
+    };
+
+  struct Glyph {
+    int      w=0,h=0;
+    int      dx=0,dy=0;
+    int      ax=0;
+    float    scale=0;
+    uint8_t* bitmap=nullptr; // per-thread scratch, valid until next rasterization on this thread
+    };
+
+  enum class Job : uint8_t {
+    Queued,
+    Running,
+    Ready,
+    };
+
+  // size independent: glyph index and advance in font units
+  struct GlyphBlock {
+    uint16_t index  [DENSE_BLOCK] = {};
+    int32_t  advance[DENSE_BLOCK] = {};
+    };
+
+  // measurement data of one size, same values as in letterGeometry
+  struct Extent {
+    static constexpr int16_t Missing = INT16_MIN; // glyph comes from fallback font, or doesn't fit
+    int16_t advance = 0;
+    int16_t top     = 0; // -dpos.y
+    int16_t bottom  = 0; // -dpos.y-size.h
+    };
+
+  struct ExtentBlock {
+    Extent e[DENSE_BLOCK];
+    };
+
+  struct DenseSize {
+    DenseSize(uint32_t key, float size):key(key),size(size){}
+    const uint32_t            key;
+    const float               size;
+    std::atomic<ExtentBlock*> block[DENSE_BLOCKS] = {};
+    };
+
+  // rasterized by prefetch, waiting to be committed into atlas
+  struct Prefetched {
+    float                size = 0;
+    char32_t             ch   = 0;
+    int                  w=0,h=0;
+    std::vector<uint8_t> pixels;
+    };
 
   template<class CharT>
   Impl(const CharT *filename) {
     if(filename==nullptr)
       return;
 
-    RFile file(filename);
-    size = uint32_t(file.size());
-    data = new uint8_t[size];
+    mapping = Detail::MappedFile(filename);
+    if(mapping.data()!=nullptr) {
+      data = mapping.data();
+      size = mapping.size();
+      } else {
+      RFile file(filename);
+      size  = file.size();
+      owned.reset(new uint8_t[size]);
+      data  = owned.get();
+      if(file.read(owned.get(),size)!=size)
+        throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+      }
+    init();
+    }
 
-    if(file.read(data,size)!=size) {
-      delete[] data;
-      throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+  Impl(const void *d, size_t sz, bool copy) {
+    size = sz;
+    if(copy) {
+      owned.reset(new uint8_t[size]);
+      std::memcpy(owned.get(), d, size);
+      data = owned.get();
+      } else {
+      data = reinterpret_cast<const uint8_t*>(d);
       }
-    if(stbtt_InitFont(&info,data,0)==0) {
-      delete[] data;
+    init();
+    }
+
+  void init() {
+    // 12 bytes - sfnt header, stb_truetype doesn't check size of data
+    if(size<12 || stbtt_InitFont(&info,data,0)==0)
       throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
-      }
     stbtt_GetFontVMetrics(&info,&metrics0.ascent,&metrics0.descent,&lineGap);
     }
 
-  Impl(const void *d, size_t sz) {
-    size = sz;
-    data = new uint8_t[size];
-    std::memcpy(data, d, size);
+  struct Cache {
+    std::mutex                                           sync;
+    std::unordered_map<std::string,std::weak_ptr<Impl>> fonts;
+    };
 
-    if(stbtt_InitFont(&info,data,0)==0) {
-      delete[] data;
-      throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+  static Cache& cache() {
+    static Cache c;
+    return c;
+    }
+
+  // one Impl per font file in process, so glyph tables are shared as well
+  template<class CharT>
+  static std::shared_ptr<Impl> open(const CharT* filename) {
+    if(filename==nullptr)
+      return std::make_shared<Impl>(filename);
+
+    std::string key;
+    if constexpr(std::is_same<CharT,char>::value)
+      key = filename; else
+      key = TextCodec::toUtf8(filename);
+
+    auto&                       c = cache();
+    std::lock_guard<std::mutex> guard(c.sync);
+    if(auto it = c.fonts.find(key); it!=c.fonts.end()) {
+      if(auto ret = it->second.lock())
+        return ret;
       }
-    stbtt_GetFontVMetrics(&info,&metrics0.ascent,&metrics0.descent,&lineGap);
+
+    auto ret = std::make_shared<Impl>(filename);
+    for(auto it=c.fonts.begin(); it!=c.fonts.end();) {
+      if(it->second.expired())
+        it = c.fonts.erase(it); else
+        ++it;
+      }
+    c.fonts[key] = ret;
+    return ret;
     }
 
   ~Impl() {
-    delete[] data;
-    std::free(rasterBuf);
+    for(auto& i:glyphs)
+      delete i.load();
+    for(auto& i:dense) {
+      auto d = i.load();
+      if(d==nullptr)
+        continue;
+      for(auto& b:d->block)
+        delete b.load();
+      delete d;
+      }
     }
 
-  uint8_t* ttfMalloc(size_t sz){
-    if(sz<rasterSz)
-      return rasterBuf;
-    sz = std::max<size_t>(sz,MIN_BUF_SZ);
-    void* p=std::realloc(rasterBuf,sz);
-    if(p==nullptr)
-      return nullptr;
-    rasterBuf=reinterpret_cast<uint8_t*>(p);
-    rasterSz =sz;
-    return rasterBuf;
+  static uint8_t* ttfMalloc(size_t sz){
+    // per-thread, so glyphs of one font can be rasterized concurrently
+    static thread_local std::vector<uint8_t> rasterBuf;
+    if(sz>rasterBuf.size())
+      rasterBuf.resize(std::max<size_t>(sz,MIN_BUF_SZ));
+    return rasterBuf.data();
     }
 
   uint8_t* getGlyphBitmapSubpixel(stbtt_fontinfo *info,
                                   float scale,int  glyph,
+                                  float shiftX,
                                   int&  width,int& height,
                                   int&  xoff, int& yoff) {
     assert(scale>0.f);
@@ -170,7 +471,7 @@ struct FontElement::Impl {
     int num_verts = stbtt_GetGlyphShape(info, glyph, &vertices);
 
     int ix0,iy0,ix1,iy1;
-    stbtt_GetGlyphBitmapBoxSubpixel(info, glyph, scale, scale, 0.f/*shift_x*/, 0.f/*shift_y*/, &ix0,&iy0,&ix1,&iy1);
+    stbtt_GetGlyphBitmapBoxSubpixel(info, glyph, scale, scale, shiftX, 0.f/*shift_y*/, &ix0,&iy0,&ix1,&iy1);
 
     stbtt__bitmap gbm={};
     // now we get the size
@@ -187,7 +488,7 @@ struct FontElement::Impl {
       gbm.pixels = ttfMalloc(size_t(gbm.w*gbm.h));
       if(gbm.pixels!=nullptr) {
         gbm.stride = gbm.w;
-        stbtt_Rasterize(&gbm, 0.35f, vertices, num_verts, scale, scale, 0.f/*shift_x*/, 0.f/*shift_y*/, ix0, iy0, 1, info->userdata);
+        stbtt_Rasterize(&gbm, 0.35f, vertices, num_verts, scale, scale, shiftX, 0.f/*shift_y*/, ix0, iy0, 1, info->userdata);
         }
       }
 
@@ -201,60 +502,323 @@ struct FontElement::Impl {
     }
 
   const Letter& letter(char32_t ch,float size,TextureAtlas* tex) {
+    if(tex!=nullptr && prefetchCount.load(std::memory_order_acquire)>0) {
+      waitPrefetch(ch,size);
+      commitPrefetch(*tex);
+      }
+
     {
     std::lock_guard<std::mutex> guard(syncMap);
+    map.trim();
     auto cc=map.find(size,ch);
     if(cc!=nullptr){
-      if(cc->hasView || tex==nullptr)
+      if(cc->hasView || tex==nullptr) {
+        ++map.hits;
         return *cc;
+        }
       }
+    ++map.misses;
     }
 
     if(this->size==0)
       return nullLater();
+    if(tex!=nullptr)
+      lookAhead(ch,size);
     return allocLetter(ch,size,tex,false);
     }
 
-  const Letter& allocLetter(char32_t ch,float size,TextureAtlas* tex,bool fallback) {
-    const float scale = stbtt_ScaleForPixelHeight(&info,size); //size/(ascent-descent);
-    if(!(scale>0.f))
-      return nullLater();
+  // glyph rasterized with horizontal shift of phase/SubpixelPhases pixel
+  const Letter& subpixelLetter(char32_t ch,float size,uint8_t phase,TextureAtlas& tex) {
+    if(phase==0)
+      return letter(ch,size,&tex);
 
-    int w=0,h=0,dx=0,dy=0;
-    int ax=0;
+    // phase is kept in high bits, unused by codepoints
+    const char32_t code = ch | (char32_t(phase)<<24);
+    {
+    std::lock_guard<std::mutex> guard(syncMap);
+    map.trim();
+    auto cc=map.find(size,code);
+    if(cc!=nullptr && cc->hasView) {
+      ++map.hits;
+      return *cc;
+      }
+    ++map.misses;
+    }
 
-    const int index = stbtt_FindGlyphIndex(&info,int(ch));
-    stbtt_GetGlyphHMetrics(&info,index,&ax,nullptr);
+    if(this->size==0)
+      return nullLater();
+
+    Glyph g;
+    if(!glyph(ch,size,true,g,float(phase)/float(SubpixelPhases)) || !(g.scale>0.f))
+      return letter(ch,size,&tex);
 
     Sprite spr;
-    if(tex!=nullptr){
+    if(g.bitmap!=nullptr) {
       std::lock_guard<std::mutex> guard(syncMem);
-      uint8_t* bitmap=getGlyphBitmapSubpixel(&info,scale,index,w,h,dx,dy);
-      if(bitmap!=nullptr)
-        spr = tex->load(bitmap,uint32_t(w),uint32_t(h),TextureFormat::R8);
+      spr = tex.load(g.bitmap,uint32_t(g.w),uint32_t(g.h),TextureFormat::R8);
+      }
+
+    std::lock_guard<std::mutex> guard(syncMap);
+    Letter& lt = publish(code,size,g);
+    if(!lt.hasView) {
+      lt.view    = std::move(spr);
+      lt.hasView = true;
+      }
+    return lt;
+    }
+
+  void prefetch(std::u32string_view charset,float size) {
+    auto self = weak_from_this().lock();
+    if(self==nullptr || this->size==0 || !(size>0.f))
+      return;
+
+    std::vector<char32_t> req;
+    {
+    std::lock_guard<std::mutex> guard(syncMap);
+    for(auto ch:charset) {
+      const uint64_t k = LetterTable::key(size,ch);
+      if(jobs.find(k)!=jobs.end())
+        continue;
+      if(auto cc = map.find(size,ch); cc!=nullptr && cc->hasView)
+        continue;
+      jobs.emplace(k,Job::Queued);
+      req.push_back(ch);
+      }
+    prefetchCount.store(jobs.size(),std::memory_order_release);
+    }
+
+    auto& pool = Detail::GlyphWorkers::inst();
+    for(auto ch:req)
+      pool.push([self,ch,size](){ self->runPrefetch(ch,size); });
+    }
+
+  void lookAhead(char32_t ch,float size) {
+    if(ch>=LOOK_AHEAD_END)
+      return;
+    const char32_t begin = ch - ch%LOOK_AHEAD_BLOCK;
+    {
+    std::lock_guard<std::mutex> guard(syncMap);
+    if(!lookAheadDone.insert(LetterTable::key(size,begin)).second)
+      return;
+    }
+
+    char32_t block[LOOK_AHEAD_BLOCK] = {};
+    size_t   cnt = 0;
+    for(char32_t i=begin; i<begin+LOOK_AHEAD_BLOCK; ++i)
+      if(i!=ch && i>=' ')
+        block[cnt++] = i;
+    prefetch(std::u32string_view(block,cnt),size);
+    }
+
+  void runPrefetch(char32_t ch,float size) {
+    const uint64_t k = LetterTable::key(size,ch);
+    {
+    std::lock_guard<std::mutex> guard(syncMap);
+    auto it = jobs.find(k);
+    if(it==jobs.end() || it->second!=Job::Queued)
+      return; // taken by letter()
+    it->second = Job::Running;
+    }
+
+    Prefetched px;
+    Glyph      g;
+    bool       ok = false;
+    try {
+      ok = glyph(ch,size,true,g);
+      if(ok && g.bitmap!=nullptr)
+        px.pixels.assign(g.bitmap,g.bitmap+size_t(g.w*g.h));
+      }
+    catch(...) {
+      ok = false;
+      }
+
+    {
+    std::lock_guard<std::mutex> guard(syncMap);
+    if(ok) {
+      publish(ch,size,g);
+      px.size = size;
+      px.ch   = ch;
+      px.w    = g.w;
+      px.h    = g.h;
+      ready.emplace_back(std::move(px));
+      jobs[k] = Job::Ready;
+      } else {
+      // missing glyphs go through fallback font in letter()
+      jobs.erase(k);
+      prefetchCount.store(jobs.size(),std::memory_order_release);
+      }
+    }
+    jobDone.notify_all();
+    }
+
+  void waitPrefetch(char32_t ch,float size) {
+    const uint64_t k = LetterTable::key(size,ch);
+    std::unique_lock<std::mutex> guard(syncMap);
+    auto it = jobs.find(k);
+    if(it==jobs.end())
+      return;
+    if(it->second==Job::Queued) {
+      // not started yet - rasterize it here, instead of waiting for whole queue
+      jobs.erase(it);
+      prefetchCount.store(jobs.size(),std::memory_order_release);
+      return;
+      }
+    jobDone.wait(guard,[&](){
+      auto i = jobs.find(k);
+      return i==jobs.end() || i->second==Job::Ready;
+      });
+    }
+
+  void commitPrefetch(TextureAtlas& tex) {
+    std::vector<Prefetched> rd;
+    {
+    std::lock_guard<std::mutex> guard(syncMap);
+    rd = std::move(ready);
+    ready.clear();
+    }
+    if(rd.empty())
+      return;
+
+    std::vector<Sprite> spr(rd.size());
+    {
+    std::lock_guard<std::mutex> guard(syncMem);
+    for(size_t i=0; i<rd.size(); ++i)
+      if(!rd[i].pixels.empty())
+        spr[i] = tex.load(rd[i].pixels.data(),uint32_t(rd[i].w),uint32_t(rd[i].h),TextureFormat::R8);
+    }
+
+    std::lock_guard<std::mutex> guard(syncMap);
+    for(size_t i=0; i<rd.size(); ++i) {
+      if(auto cc = map.find(rd[i].size,rd[i].ch); cc!=nullptr && !cc->hasView) {
+        cc->view    = std::move(spr[i]);
+        cc->hasView = true;
+        }
+      jobs.erase(LetterTable::key(rd[i].size,rd[i].ch));
+      }
+    prefetchCount.store(jobs.size(),std::memory_order_release);
+    }
+
+  const Letter& distanceFieldLetter(char32_t ch,float size,TextureAtlas& tex) {
+    {
+    std::lock_guard<std::mutex> guard(syncMap);
+    mapDf.trim();
+    auto cc=mapDf.find(size,ch);
+    if(cc!=nullptr) {
+      ++mapDf.hits;
+      return *cc;
+      }
+    ++mapDf.misses;
+    }
+
+    if(this->size==0)
+      return nullLater();
+
+    const float scale    = stbtt_ScaleForPixelHeight(&info,size);
+    const float refScale = stbtt_ScaleForPixelHeight(&info,DF_REF_SIZE);
+    if(!(scale>0.f) || !(refScale>0.f))
+      return nullLater();
+
+    int ax=0;
+    const int index = glyphMetrics(ch,ax);
+
+    const DistanceField& df = distanceField(index,refScale,tex);
+    const float          k  = scale/refScale;
+
+    std::lock_guard<std::mutex> guard(syncMap);
+    Letter& lt = mapDf.at(size,ch);
+    if(lt.hasView)
+      return lt; // published by another thread
+    lt.view          = df.view;
+    lt.size          = Size (int(std::lround(float(df.w)*k)), int(std::lround(float(df.h)*k)));
+    lt.dpos          = Point(int(std::lround(float(df.dx)*k)),int(std::lround(float(df.dy)*k)));
+    lt.advance       = Point(int(ax*scale),int(lineGap*scale));
+    lt.hasView       = true;
+    lt.distanceField = true;
+    return lt;
+    }
+
+  const DistanceField& distanceField(int index,float refScale,TextureAtlas& tex) {
+    std::lock_guard<std::mutex> guard(syncMem);
+    auto it = dfGlyphs.find(index);
+    if(it!=dfGlyphs.end())
+      return it->second;
+
+    DistanceField df;
+    uint8_t* bitmap = stbtt_GetGlyphSDF(&info,refScale,index,DF_PADDING,DF_ONEDGE,float(DF_ONEDGE)/float(DF_PADDING),
+                                        &df.w,&df.h,&df.dx,&df.dy);
+    if(bitmap!=nullptr) {
+      try {
+        df.view = tex.load(bitmap,uint32_t(df.w),uint32_t(df.h),TextureFormat::R8);
+        }
+      catch(...) {
+        stbtt_FreeSDF(bitmap,info.userdata);
+        throw;
+        }
+      stbtt_FreeSDF(bitmap,info.userdata);
+      } else {
+      df = DistanceField();
+      }
+    return dfGlyphs.emplace(index,std::move(df)).first->second;
+    }
+
+  // returns false for glyph, that has to be taken from fallback font
+  bool glyph(char32_t ch,float size,bool bitmap,Glyph& g,float shiftX=0.f) {
+    g.scale = stbtt_ScaleForPixelHeight(&info,size); //size/(ascent-descent);
+    if(!(g.scale>0.f))
+      return true;
+
+    const int index = glyphMetrics(ch,g.ax);
+
+    if(bitmap) {
+      g.bitmap = getGlyphBitmapSubpixel(&info,g.scale,index,shiftX,g.w,g.h,g.dx,g.dy);
       } else {
       int ix0=0,ix1=0,iy0=0,iy1=0;
-      stbtt_GetGlyphBitmapBoxSubpixel(&info,index,scale,scale,0.f,0.f,&ix0,&iy0,&ix1,&iy1);
+      stbtt_GetGlyphBitmapBoxSubpixel(&info,index,g.scale,g.scale,0.f,0.f,&ix0,&iy0,&ix1,&iy1);
+
+      g.w  = (ix1 - ix0);
+      g.h  = (iy1 - iy0);
+      g.dx = ix0;
+      g.dy = iy0;
+      }
+    return !((g.w<=0 || g.h<=0) && g.ax==0);
+    }
 
-      w  = (ix1 - ix0);
-      h  = (iy1 - iy0);
-      dx = ix0;
-      dy = iy0;
+  // syncMap must be locked
+  Letter& publish(char32_t ch,float size,const Glyph& g) {
+    if(auto cc = map.find(size,ch)) {
+      // geometry is already published and may be read without lock
+      return *cc;
       }
+    Letter& lt = map.at(size,ch);
+    lt.size    = Size(g.w,g.h);
+    lt.dpos    = Point(g.dx,g.dy);
+    lt.advance = Point(int(float(g.ax)*g.scale),int(float(lineGap)*g.scale));
+    lt.hasView = false;
+    return lt;
+    }
 
-    if((w<=0 || h<=0) && ax==0) {
+  const Letter& allocLetter(char32_t ch,float size,TextureAtlas* tex,bool fallback) {
+    Glyph g;
+    if(!glyph(ch,size,tex!=nullptr,g)) {
       if(!fallback)
         return allocFallbackLetter(ch,size,tex);
       return nullLater();
       }
+    if(!(g.scale>0.f))
+      return nullLater();
+
+    Sprite spr;
+    if(g.bitmap!=nullptr) {
+      std::lock_guard<std::mutex> guard(syncMem);
+      spr = tex->load(g.bitmap,uint32_t(g.w),uint32_t(g.h),TextureFormat::R8);
+      }
 
     std::lock_guard<std::mutex> guard(syncMap);
-    Letter& lt = map.at(size,ch);
-    lt.view    = std::move(spr);
-    lt.size    = Size(w,h);
-    lt.dpos    = Point(dx,dy);
-    lt.advance = Point(int(ax*scale),int(lineGap*scale));
-    lt.hasView = (tex!=nullptr);
+    Letter& lt = publish(ch,size,g);
+    if(!lt.hasView && tex!=nullptr) {
+      lt.view    = std::move(spr);
+      lt.hasView = true;
+      }
     return lt;
     }
 
@@ -277,6 +841,184 @@ struct FontElement::Impl {
       }
     }
 
+  void setGlyphBudget(size_t count) {
+    std::lock_guard<std::mutex> guard(syncMap);
+    map  .setBudget(count);
+    mapDf.setBudget(count);
+    }
+
+  CacheStats cacheStats() {
+    std::lock_guard<std::mutex> guard(syncMap);
+    CacheStats st;
+    for(auto* m:{&map,&mapDf}) {
+      st.glyphs    += m->count;
+      st.hits      += m->hits;
+      st.misses    += m->misses;
+      st.evictions += m->evictions;
+      st.memory    += m->memoryUsage();
+      }
+    return st;
+    }
+
+  // first writer wins, blocks are immutable after publishing
+  template<class T>
+  static T* publishBlock(std::atomic<T*>& dst, T* blk) {
+    T* prev = nullptr;
+    if(dst.compare_exchange_strong(prev,blk,std::memory_order_acq_rel))
+      return blk;
+    delete blk;
+    return prev;
+    }
+
+  int glyphMetrics(char32_t ch,int& ax) {
+    if(ch>=0x10000) {
+      const int index = stbtt_FindGlyphIndex(&info,int(ch));
+      stbtt_GetGlyphHMetrics(&info,index,&ax,nullptr);
+      return index;
+      }
+    const GlyphBlock& b = glyphBlock(ch/DENSE_BLOCK);
+    ax = b.advance[ch%DENSE_BLOCK];
+    return b.index[ch%DENSE_BLOCK];
+    }
+
+  const GlyphBlock& glyphBlock(uint32_t id) {
+    if(auto b = glyphs[id].load(std::memory_order_acquire))
+      return *b;
+    auto b = new GlyphBlock();
+    for(uint32_t i=0; i<DENSE_BLOCK; ++i) {
+      const int index = stbtt_FindGlyphIndex(&info,int(id*DENSE_BLOCK+i));
+      int       ax    = 0;
+      stbtt_GetGlyphHMetrics(&info,index,&ax,nullptr);
+      b->index  [i] = uint16_t(index);
+      b->advance[i] = ax;
+      }
+    return *publishBlock(glyphs[id],b);
+    }
+
+  DenseSize* denseSize(float size) {
+    const uint32_t key = uint32_t(size*100);
+    for(auto& i:dense) {
+      auto d = i.load(std::memory_order_acquire);
+      if(d==nullptr)
+        d = publishBlock(i,new DenseSize(key,size));
+      if(d->key==key)
+        return d;
+      }
+    return nullptr;
+    }
+
+  const ExtentBlock& extentBlock(DenseSize& ds,uint32_t id) {
+    if(auto b = ds.block[id].load(std::memory_order_acquire))
+      return *b;
+    auto  b     = new ExtentBlock();
+    auto& gb    = glyphBlock(id);
+    float scale = stbtt_ScaleForPixelHeight(&info,ds.size);
+    for(uint32_t i=0; i<DENSE_BLOCK && scale>0.f; ++i) {
+      int ix0=0,ix1=0,iy0=0,iy1=0;
+      stbtt_GetGlyphBitmapBoxSubpixel(&info,gb.index[i],scale,scale,0.f,0.f,&ix0,&iy0,&ix1,&iy1);
+
+      const int w   = ix1-ix0, h = iy1-iy0;
+      const int adv = int(float(gb.advance[i])*scale);
+      auto&     e   = b->e[i];
+      if(((w<=0 || h<=0) && gb.advance[i]==0) || std::max({std::abs(adv),std::abs(iy0),std::abs(iy1)})>INT16_MAX) {
+        e.advance = Extent::Missing;
+        continue;
+        }
+      e.advance = int16_t(adv);
+      e.top     = int16_t(-iy0);
+      e.bottom  = int16_t(-iy0-h);
+      }
+    return *publishBlock(ds.block[id],b);
+    }
+
+  bool hasKerning() {
+    std::call_once(kernLoaded,[this](){
+      // only 'kern' table is supported by stb_truetype, GPOS kerning is ignored
+      std::vector<stbtt_kerningentry> tbl(size_t(std::max(0,stbtt_GetKerningTableLength(&info))));
+      tbl.resize(size_t(stbtt_GetKerningTable(&info,tbl.data(),int(tbl.size()))));
+      kernPairs.reserve(tbl.size());
+      for(auto& i:tbl)
+        kernPairs[(uint32_t(i.glyph1)<<16) | uint32_t(i.glyph2)] = int16_t(i.advance);
+      });
+    return !kernPairs.empty();
+    }
+
+  int kerning(char32_t l,char32_t r,float size) {
+    if(!hasKerning())
+      return 0;
+
+    int ax = 0;
+    const uint32_t g1 = uint32_t(glyphMetrics(l,ax));
+    const uint32_t g2 = uint32_t(glyphMetrics(r,ax));
+    auto it = kernPairs.find((g1<<16) | g2);
+    if(it==kernPairs.end())
+      return 0;
+    return int(std::lround(float(it->second)*stbtt_ScaleForPixelHeight(&info,size)));
+    }
+
+  Size textSize(const char* text,float sz,bool kern) {
+    Size ret;
+    if(text==nullptr)
+      return ret;
+
+    DenseSize*     ds    = this->size==0 ? nullptr : denseSize(sz);
+    const bool     kp    = kern && this->size!=0 && hasKerning();
+    const auto     str   = reinterpret_cast<const uint8_t*>(text);
+    const size_t   len   = std::strlen(text);
+    int            minY  = 0;
+    char32_t       prev  = 0;
+
+    auto add = [&](char32_t c, const Extent* e) {
+      if(e!=nullptr && e->advance!=Extent::Missing) {
+        ret.h  = std::max<int>(ret.h,e->top);
+        minY   = std::min<int>(minY, e->bottom);
+        ret.w += e->advance;
+        } else {
+        auto& g = letter(c,sz,nullptr);
+        ret.h  = std::max(ret.h,-g.dpos.y);
+        minY   = std::min(minY, -g.dpos.y-g.size.h);
+        ret.w += g.advance.x;
+        }
+      if(kp) {
+        if(prev!=0)
+          ret.w += kerning(prev,c,sz);
+        prev = c;
+        }
+      };
+
+    for(size_t i=0; i<len;) {
+#if defined(T_FONT_SSE2)
+      if(ds!=nullptr && !kp && i+16<=len) {
+        // ascii fast path: 16 characters at once, if none of them has high bit set
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str+i));
+        if(_mm_movemask_epi8(v)==0) {
+          const ExtentBlock& b = extentBlock(*ds,0);
+          for(size_t r=0; r<16; ++r)
+            add(str[i+r],&b.e[str[i+r]]);
+          i += 16;
+          continue;
+          }
+        }
+#endif
+      Utf8Iterator it(text+i,len-i);
+      const char32_t c = it.next();
+      if(c=='\0')
+        break;
+      i += it.pos();
+      if(ds!=nullptr && c<0x10000)
+        add(c,&extentBlock(*ds,c/DENSE_BLOCK).e[c%DENSE_BLOCK]); else
+        add(c,nullptr);
+      }
+
+    ret.h+=minY;
+    return ret;
+    }
+
+  bool hasGlyph(char32_t ch) {
+    int ax = 0;
+    return this->size!=0 && glyphMetrics(ch,ax)!=0;
+    }
+
   Metrics       metrics(float size) const {
     if(this->size==0)
       return Metrics();
@@ -287,19 +1029,90 @@ struct FontElement::Impl {
     return m;
     }
 
-  uint8_t*       data=nullptr;
-  size_t         size=0;
-  stbtt_fontinfo info={};
+  const uint8_t*             data=nullptr;
+  size_t                     size=0;
+  std::unique_ptr<uint8_t[]> owned;
+  Detail::MappedFile         mapping;
+  stbtt_fontinfo             info={};
 
   std::mutex     syncMem;
-  uint8_t*       rasterBuf=nullptr;
-  size_t         rasterSz =0;
   Metrics        metrics0;
   int            lineGap=0;
 
   std::mutex                           syncMap;
   LetterTable                          map;
+  LetterTable                          mapDf;
+  std::unordered_map<int,DistanceField> dfGlyphs;
   std::unique_ptr<Impl>                fallback;
+
+  std::unordered_map<uint64_t,Job>     jobs;
+  std::vector<Prefetched>              ready;
+  std::unordered_set<uint64_t>         lookAheadDone;
+  std::condition_variable              jobDone;
+  std::atomic<size_t>                  prefetchCount{0};
+
+  std::atomic<GlyphBlock*>             glyphs[DENSE_BLOCKS] = {};
+  std::atomic<DenseSize*>              dense [DENSE_SIZES]  = {};
+  std::once_flag                       kernLoaded;
+  std::unordered_map<uint32_t,int16_t> kernPairs;
+  };
+
+// codepoint to face resolution, shared by copies of Font
+struct Font::Fallback {
+  enum { BLOCK=256, BLOCKS=0x10000/BLOCK, STYLES=4 };
+
+  // 0 - own face of the font, i - faces[i-1]
+  struct Block {
+    uint16_t face[BLOCK] = {};
+    };
+
+  ~Fallback() {
+    for(auto& s:block)
+      for(auto& b:s)
+        delete b.load();
+    }
+
+  uint16_t find(const FontElement& primary, char32_t ch) const {
+    if(primary.hasGlyph(ch))
+      return 0;
+    for(size_t i=0; i<faces.size(); ++i)
+      if(faces[i].hasGlyph(ch))
+        return uint16_t(i+1);
+    // missing everywhere: .notdef of own face
+    return 0;
+    }
+
+  uint16_t resolve(const FontElement& primary, uint8_t style, char32_t ch) {
+    if(ch>=0x10000) {
+      const uint64_t              k = (uint64_t(style)<<32) | ch;
+      std::lock_guard<std::mutex> guard(sync);
+      if(auto it = astral.find(k); it!=astral.end())
+        return it->second;
+      return astral[k] = find(primary,ch);
+      }
+
+    auto& dst = block[style][ch/BLOCK];
+    if(auto b = dst.load(std::memory_order_acquire))
+      return b->face[ch%BLOCK];
+
+    // whole block at once, from cmaps of all faces
+    auto           b     = new Block();
+    const char32_t begin = ch - ch%BLOCK;
+    for(uint32_t i=0; i<BLOCK; ++i)
+      b->face[i] = find(primary,begin+i);
+
+    Block* prev = nullptr;
+    if(!dst.compare_exchange_strong(prev,b,std::memory_order_acq_rel)) {
+      delete b;
+      b = prev;
+      }
+    return b->face[ch%BLOCK];
+    }
+
+  std::vector<FontElement>              faces;
+  std::atomic<Block*>                   block[STYLES][BLOCKS] = {};
+  std::mutex                            sync;
+  std::unordered_map<uint64_t,uint16_t> astral;
   };
 
 FontElement::FontElement() {
@@ -313,7 +1126,7 @@ FontElement::FontElement(std::nullptr_t)
 
 template<class CharT>
 FontElement::FontElement(const CharT *file,std::true_type)
-  :ptr(std::make_shared<Impl>(file)) {
+  :ptr(Impl::open(file)) {
   }
 
 FontElement::FontElement(const char *file)
@@ -333,7 +1146,15 @@ FontElement::FontElement(const std::u16string& file)
   }
 
 FontElement::FontElement(const void* data, size_t size)
-  :ptr(std::make_shared<Impl>(data,size)) {
+  :ptr(std::make_shared<Impl>(data,size,true)) {
+  }
+
+FontElement::FontElement(std::shared_ptr<Impl>&& impl)
+  :ptr(std::move(impl)) {
+  }
+
+FontElement FontElement::fromStaticData(const void* data, size_t size) {
+  return FontElement(std::make_shared<Impl>(data,size,false));
   }
 
 const FontElement::LetterGeometry& FontElement::letterGeometry(char32_t ch, float size) const { //FIXME: UB?
@@ -344,34 +1165,48 @@ const FontElement::Letter& FontElement::letter(char32_t ch, float size, TextureA
   return ptr->letter(ch,size,&tex);
   }
 
-Size FontElement::textSize(const char *text, float fontSize) const {
-  Utf8Iterator i(text);
+const FontElement::Letter& FontElement::letter(char32_t ch, float size, uint8_t phase, TextureAtlas& tex) const {
+  return ptr->subpixelLetter(ch,size,uint8_t(phase%SubpixelPhases),tex);
+  }
 
-  Size ret;
-  int  minY = 0;
-  while(i.hasData()){
-    char32_t c = i.next();
-    if(c=='\0')
-      return ret;
-    auto& g = letterGeometry(c,fontSize);
+const FontElement::Letter& FontElement::distanceFieldLetter(char32_t ch, float size, TextureAtlas& tex) const {
+  return ptr->distanceFieldLetter(ch,size,tex);
+  }
 
-    ret.h = std::max(ret.h,-g.dpos.y);
-    minY  = std::min(minY, -g.dpos.y-g.size.h);
-    ret.w += g.advance.x;
-    }
+Size FontElement::textSize(const char* text, float fontSize, bool kerning) const {
+  return ptr->textSize(text,fontSize,kerning);
+  }
 
-  ret.h+=minY;
-  return ret;
+int FontElement::kerning(char32_t left, char32_t right, float size) const {
+  if(ptr->size==0)
+    return 0;
+  return ptr->kerning(left,right,size);
   }
 
 bool FontElement::isEmpty() const {
   return ptr->size==0;
   }
 
+bool FontElement::hasGlyph(char32_t ch) const {
+  return ptr->hasGlyph(ch);
+  }
+
 FontElement::Metrics FontElement::metrics(float size) const {
   return ptr->metrics(size);
   }
 
+void FontElement::prefetch(std::u32string_view charset, float size) {
+  ptr->prefetch(charset,size);
+  }
+
+void FontElement::setGlyphBudget(size_t count) {
+  ptr->setGlyphBudget(count);
+  }
+
+FontElement::CacheStats FontElement::cacheStats() const {
+  return ptr->cacheStats();
+  }
+
 template<class CharT>
 Font::Font(const CharT *file,std::true_type)
   : fnt{{file,nullptr},{nullptr,nullptr}}{
@@ -424,6 +1259,89 @@ bool Font::isItalic() const {
   return italic;
   }
 
+void Font::setKerning(bool k) {
+  kern = k;
+  }
+
+bool Font::isKerning() const {
+  return kern;
+  }
+
+int Font::kerning(char32_t left, char32_t right) const {
+  if(!kern)
+    return 0;
+  auto& f = face(left);
+  if(&f!=&face(right))
+    return 0;
+  return f.kerning(left,right,size);
+  }
+
+void Font::setSubpixelPositioning(bool sp) {
+  subpixel = sp;
+  }
+
+bool Font::isSubpixelPositioning() const {
+  return subpixel && !dField;
+  }
+
+void Font::setDistanceField(bool df) {
+  dField = df;
+  }
+
+bool Font::isDistanceField() const {
+  return dField;
+  }
+
+void Font::prefetch(std::u32string_view charset) {
+  if(dField)
+    return;
+  if(fallback==nullptr) {
+    fnt[bold][italic].prefetch(charset,size);
+    return;
+    }
+
+  std::vector<std::u32string> perFace(fallback->faces.size()+1);
+  for(auto ch:charset)
+    perFace[fallback->resolve(fnt[bold][italic],uint8_t(bold*2+italic),ch)].push_back(ch);
+  for(size_t i=0; i<perFace.size(); ++i) {
+    if(perFace[i].empty())
+      continue;
+    auto& f = (i==0 ? fnt[bold][italic] : fallback->faces[i-1]);
+    f.prefetch(perFace[i],size);
+    }
+  }
+
+void Font::setGlyphBudget(size_t count) {
+  for(auto& i:fnt)
+    for(auto& f:i)
+      f.setGlyphBudget(count);
+  if(fallback!=nullptr) {
+    for(auto& f:fallback->faces)
+      f.setGlyphBudget(count);
+    }
+  }
+
+void Font::addFallback(const FontElement& f) {
+  // copy on write: other copies of this Font keep their chain
+  auto fb = std::make_shared<Fallback>();
+  if(fallback!=nullptr)
+    fb->faces = fallback->faces;
+  fb->faces.push_back(f);
+  fallback = std::move(fb);
+  }
+
+void Font::clearFallback() {
+  fallback = nullptr;
+  }
+
+const FontElement& Font::face(char32_t ch) const {
+  auto& f = fnt[bold][italic];
+  if(fallback==nullptr)
+    return f;
+  const uint16_t id = fallback->resolve(f,uint8_t(bold*2+italic),ch);
+  return id==0 ? f : fallback->faces[id-1];
+  }
+
 bool Font::isEmpty() const {
   return fnt[0][0].isEmpty() || fnt[0][1].isEmpty() ||
          fnt[1][0].isEmpty() || fnt[1][1].isEmpty();
@@ -434,19 +1352,28 @@ Font::Metrics Font::metrics() const {
   }
 
 const Font::LetterGeometry &Font::letterGeometry(char16_t ch) const {
-  return fnt[bold][italic].letterGeometry(ch,size);
+  return letterGeometry(char32_t(ch));
   }
 
 const Font::LetterGeometry &Font::letterGeometry(char32_t ch) const {
-  return fnt[bold][italic].letterGeometry(ch,size);
+  return face(ch).letterGeometry(ch,size);
   }
 
 const Font::Letter &Font::letter(char16_t ch, TextureAtlas &tex) const {
-  return fnt[bold][italic].letter(ch,size,tex);
+  return letter(char32_t(ch),tex);
   }
 
 const Font::Letter &Font::letter(char32_t ch, TextureAtlas &tex) const {
-  return fnt[bold][italic].letter(ch,size,tex);
+  auto& f = face(ch);
+  if(dField)
+    return f.distanceFieldLetter(ch,size,tex);
+  return f.letter(ch,size,tex);
+  }
+
+const Font::Letter& Font::letter(char32_t ch, uint8_t phase, TextureAtlas& tex) const {
+  if(dField || phase==0)
+    return letter(ch,tex);
+  return face(ch).letter(ch,size,phase,tex);
   }
 
 const Font::Letter &Font::letter(char16_t ch, Painter &p) const {
@@ -458,7 +1385,29 @@ const Font::Letter &Font::letter(char32_t ch, Painter &p) const {
   }
 
 Size Font::textSize(const char *text) const {
-  return fnt[bold][italic].textSize(text,size);
+  if(fallback==nullptr)
+    return fnt[bold][italic].textSize(text,size,kern);
+
+  // characters may come from different faces: measured one by one
+  Size ret;
+  if(text==nullptr)
+    return ret;
+
+  int          minY = 0;
+  char32_t     prev = 0;
+  Utf8Iterator i(text);
+  while(i.hasData()) {
+    const char32_t c = i.next();
+    if(c=='\0')
+      break;
+    auto& g = letterGeometry(c);
+    ret.h  = std::max(ret.h,-g.dpos.y);
+    minY   = std::min(minY, -g.dpos.y-g.size.h);
+    ret.w += g.advance.x + kerning(prev,c);
+    prev   = c;
+    }
+  ret.h += minY;
+  return ret;
   }
 
 Size Font::textSize(const std::string &text) const {
@@ -481,6 +1430,7 @@ Size Font::textSize(int maxW, const char* txt) const {
       break;
 
     x = 0;
+    char32_t prev = 0;
     while(i!=eol) {
       auto c = i.next();
       if(c=='\0')
@@ -488,7 +1438,8 @@ Size Font::textSize(int maxW, const char* txt) const {
       if(c=='\n' || c=='\r')
         continue;
       auto l = letterGeometry(c);
-      x += l.advance.x;
+      x += l.advance.x + kerning(prev,c);
+      prev = c;
       }
     ret.w = std::max(ret.w,x);
     ret.h += pSz;
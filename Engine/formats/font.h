@@ -5,6 +5,7 @@
 #include <Tempest/Sprite>
 
 #include <string>
+#include <string_view>
 #include <memory>
 
 namespace Tempest {
@@ -15,12 +16,19 @@ class FontElement final {
   public:
     FontElement();
     FontElement(std::nullptr_t);
+    // font files are memory-mapped, elements opened from the same path share data and glyph cache
     FontElement(const char* file);
     FontElement(const std::string&    file);
     FontElement(const char16_t*       file);
     FontElement(const std::u16string& file);
     FontElement(const void* data, size_t size);
 
+    static constexpr uint8_t SubpixelPhases = 4;
+
+    // Uses data in place, without copy: it must outlive all copies of returned FontElement.
+    // Intended for static or embedded font data.
+    static FontElement fromStaticData(const void* data, size_t size);
+
     class LetterGeometry final {
       public:
         Tempest::Size  size;
@@ -33,22 +41,49 @@ class FontElement final {
         int descent=0;
       };
 
+    class CacheStats final {
+      public:
+        size_t glyphs    = 0;
+        size_t hits      = 0;
+        size_t misses    = 0;
+        size_t evictions = 0;
+        size_t memory    = 0; // bytes used by glyph tables, atlas pages are not included
+      };
+
     class Letter final {
       public:
         Tempest::Size   size;
         Tempest::Point  dpos, advance;
         Tempest::Sprite view;
         bool            hasView=false;
+        bool            distanceField=false;
       };
 
     const LetterGeometry& letterGeometry(char32_t ch, float size) const;
     const Letter&         letter(char32_t ch,float size,TextureAtlas& tex) const;
+    // glyph variant, shifted right by phase/SubpixelPhases of pixel; variants are rasterized on first use
+    const Letter&         letter(char32_t ch,float size,uint8_t phase,TextureAtlas& tex) const;
+    const Letter&         distanceFieldLetter(char32_t ch,float size,TextureAtlas& tex) const;
 
-    Size                  textSize(const char* text, float fontSize) const;
+    Size                  textSize(const char* text, float fontSize, bool kerning=false) const;
     Size                  textSize(const char* text, int maxW, float fontSize) const;
     bool                  isEmpty() const;
+    // true, if character is mapped by cmap of this font
+    bool                  hasGlyph(char32_t ch) const;
 
     Metrics               metrics(float size) const;
+    // in pixels, from 'kern' table of the font
+    int                   kerning(char32_t left, char32_t right, float size) const;
+
+    // Rasterizes glyphs on background threads, they are committed to atlas by next letter() call.
+    void                  prefetch(std::u32string_view charset, float size);
+
+    // Limits count of cached glyphs (per bitmap and distance-field caches), 0 - unlimited.
+    // Least recently used glyphs are evicted and release their atlas sprites, so with
+    // budget set Letter references stay valid only until next glyph is requested.
+    // Eviction runs only in letter() calls, never on prefetch threads.
+    void                  setGlyphBudget(size_t count);
+    CacheStats            cacheStats() const;
 
   private:
     template<class CharT>
@@ -56,6 +91,8 @@ class FontElement final {
 
     struct LetterTable;
     struct Impl;
+    FontElement(std::shared_ptr<Impl>&& impl);
+
     std::shared_ptr<Impl> ptr;
   };
 
@@ -82,14 +119,36 @@ class Font final {
     void  setItalic(bool i);
     bool  isItalic() const;
 
+    void  setDistanceField(bool df);
+    bool  isDistanceField() const;
+
+    // Painter places glyphs with 1/SubpixelPhases of device pixel precision horizontally,
+    // instead of snapping them to whole pixels. Ignored for distance-field fonts, disabled by default
+    void  setSubpixelPositioning(bool sp);
+    bool  isSubpixelPositioning() const;
+
+    // kerning is applied by textSize and Painter::drawText, disabled by default
+    void  setKerning(bool k);
+    bool  isKerning() const;
+    int   kerning(char32_t left, char32_t right) const;
+
     bool  isEmpty() const;
 
+    void  setGlyphBudget(size_t count);
+    void  prefetch(std::u32string_view charset);
+
+    // Faces for characters, that are missing in this font (e.g. CJK, emoji), searched in order of addition.
+    // Same fallback chain is used for every style; glyphs are cached by the face they come from.
+    void  addFallback(const FontElement& face);
+    void  clearFallback();
+
     Metrics               metrics() const;
 
     const LetterGeometry& letterGeometry(char16_t ch) const;
     const LetterGeometry& letterGeometry(char32_t ch) const;
     const Letter&         letter(char16_t ch,TextureAtlas& tex) const;
     const Letter&         letter(char32_t ch,TextureAtlas& tex) const;
+    const Letter&         letter(char32_t ch,uint8_t phase,TextureAtlas& tex) const;
 
     const Letter&         letter(char16_t ch,Painter& tex) const;
     const Letter&         letter(char32_t ch,Painter& tex) const;
@@ -104,9 +163,16 @@ class Font final {
     template<class CharT>
     Font(const CharT* file,std::true_type);
 
-    FontElement fnt[2][2];
-    float       size   = 18.f;
-    uint8_t     bold   = 0;
-    uint8_t     italic = 0;
+    struct Fallback;
+    const FontElement& face(char32_t ch) const;
+
+    FontElement               fnt[2][2];
+    std::shared_ptr<Fallback> fallback;
+    float                     size     = 18.f;
+    uint8_t                   bold     = 0;
+    uint8_t                   italic   = 0;
+    bool                      dField   = false;
+    bool                      kern     = false;
+    bool                      subpixel = false;
   };
 }
@@ -179,7 +179,8 @@ namespace Tempest {
     R,
     G,
     B,
-    A
+    A,
+    One
     };
 
   struct ComponentMapping final {
@@ -664,6 +665,9 @@ namespace Tempest {
       virtual void       readPixels   (Device* d, Pixmap& out, const PTexture t,
                                        TextureFormat frm, const uint32_t w, const uint32_t h, uint32_t mip, bool storageImg) = 0;
       virtual void       readBytes    (Device* d, Buffer* buf, void* out, size_t size) = 0;
+      // tightly packed w*h texels to mip 0 at (x,y); ordered after previously submitted work, that samples the texture
+      virtual void       updateTexture(Device* d, PTexture t, const void* data, TextureFormat frm,
+                                       uint32_t x, uint32_t y, uint32_t w, uint32_t h) = 0;
 
       virtual void       present  (Device *d, Swapchain* sw)=0;
       virtual void       submit   (Device *d, CommandBuffer*  cmd, Fence* fence)=0;
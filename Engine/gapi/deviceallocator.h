@@ -3,8 +3,14 @@
 #include <cstdint>
 #include <forward_list>
 #include <mutex>
+#include <atomic>
+#include <new>
 #include <algorithm>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace Tempest {
 namespace Detail {
 
@@ -12,6 +18,7 @@ template<class MemoryProvider>
 class DeviceAllocator {
   struct Page;
   struct Block;
+  struct Shard;
   public:
     enum {
       DEFAULT_PAGE_SIZE=128*1024*1024
@@ -19,44 +26,90 @@ class DeviceAllocator {
     using Memory=typename MemoryProvider::DeviceMemory;
     static const constexpr Memory null=Memory{};
 
-    explicit DeviceAllocator(MemoryProvider& device):device(device){}
+    explicit DeviceAllocator(MemoryProvider& device):device(device){
+      for(auto& heap:shards)
+        heap[1].small = true;
+      }
 
     DeviceAllocator(const DeviceAllocator&)=delete;
 
     ~DeviceAllocator(){
-      for(auto& i:pages)
-        device.free(i.memory,i.size,i.typeId);
+      for(auto& heap:shards)
+        for(auto& s:heap)
+          for(auto& i:s.pages)
+            device.free(i.memory,i.size,i.typeId);
       }
 
     struct Allocation {
       Page*  page  =nullptr;
       size_t offset=0,size=0;
+      Block* block =nullptr; // internal: range of page, that holds this allocation
       };
 
     Allocation alloc(size_t size, size_t align, uint32_t heapId, uint32_t typeId, bool hostVisible) {
-      std::lock_guard<std::mutex> guard(sync);
-      for(auto& i:pages){
-        if(i.heapId==heapId && i.allocated+size<=i.allSize){
-          auto ret=i.alloc(size,align,device);
-          if(ret.page!=nullptr)
-            return ret;
+      if(size>SmallSize) {
+        Shard& s = shard(heapId,false);
+        std::lock_guard<std::mutex> guard(s.sync);
+        return alloc(s,uint32_t(size),size,align,heapId,typeId,hostVisible);
+        }
+
+      // small allocations are rounded to size class, so recently freed ones can be reused as is
+      const uint32_t cls = Page::roundUp(std::max<uint32_t>(uint32_t(size),1));
+      Magazine&      m   = magazine();
+      {
+      std::lock_guard<std::mutex> guard(m.sync);
+      for(size_t i=m.size; i>0;) {
+        --i;
+        Allocation& c = m.cache[i];
+        if(c.page->heapId==heapId && c.block->size==cls && c.offset%align==0) {
+          Allocation ret = c;
+          ret.size = size;
+          c = m.cache[--m.size];
+          ret.page->live.fetch_add(1,std::memory_order_relaxed);
+          return ret;
           }
         }
-      return rawAlloc(size,align,heapId,typeId,hostVisible,false);
+      }
+
+      Shard& s = shard(heapId,true);
+      std::lock_guard<std::mutex> guard(s.sync);
+      return alloc(s,cls,size,align,heapId,typeId,hostVisible);
       }
 
     void free(const Allocation& a){
-      std::lock_guard<std::mutex> guard(sync);
-      a.page->free(a);
-      if(a.page->allocated==0){
-        device.free(a.page->memory,a.page->size,a.page->typeId);
-        pages.remove(*a.page);
+      if(a.page->live.fetch_sub(1,std::memory_order_relaxed)==1) {
+        // last allocation of the page: cached ones would keep it alive
+        if(a.page->shard->small)
+          flushMagazines([p=a.page](const Page* pg){ return pg==p; });
+        release(a);
+        return;
+        }
+      if(a.page->shard->small) {
+        Magazine&  m = magazine();
+        Allocation spill[MagazineSize/2];
+        {
+        std::lock_guard<std::mutex> guard(m.sync);
+        if(m.size<MagazineSize) {
+          m.cache[m.size++] = a;
+          return;
+          }
+        // oldest half goes back to pages
+        std::copy(m.cache,m.cache+MagazineSize/2,spill);
+        std::copy(m.cache+MagazineSize/2,m.cache+MagazineSize,m.cache);
+        m.cache[MagazineSize/2] = a;
+        m.size = MagazineSize/2+1;
         }
+        for(auto& i:spill)
+          release(i);
+        return;
+        }
+      release(a);
       }
 
     Allocation dedicatedAlloc(size_t size, size_t align, uint32_t heapId, uint32_t typeId, bool hostVisible) {
-      std::lock_guard<std::mutex> guard(sync);
-      return rawAlloc(size,align,heapId,typeId,hostVisible,true);
+      Shard& s = shard(heapId,false);
+      std::lock_guard<std::mutex> guard(s.sync);
+      return rawAlloc(s,uint32_t(size),size,align,heapId,typeId,hostVisible,true);
       }
 
     void setDefaultPageSize(uint32_t sz) {
@@ -64,193 +117,421 @@ class DeviceAllocator {
       }
 
   private:
-    Allocation rawAlloc(size_t size, size_t align, uint32_t heapId, uint32_t typeId, bool hostVisible, bool dedicated){
-      const uint32_t pgSize = (dedicated ? uint32_t(size) : std::max<uint32_t>(defPageSize,uint32_t(size)));
-      Page pg(pgSize);
-      pg.memory      = device.alloc(pg.allSize,typeId);
-      pg.typeId      = typeId;
-      pg.heapId      = heapId;
-      pg.hostVisible = hostVisible;
-      if(pg.memory==null)
+    enum {
+      SmallSize    = 64*1024,
+      ShardHeaps   = 16,
+      Magazines    = 8,
+      MagazineSize = 32,
+      };
+
+    // pages of one heap (modulo ShardHeaps) and size category, with own lock
+    struct Shard {
+      std::mutex              sync;
+      std::forward_list<Page> pages;
+      bool                    small = false;
+      };
+
+    // recently freed small allocations; threads are spread over magazines
+    struct Magazine {
+      std::mutex sync;
+      Allocation cache[MagazineSize];
+      size_t     size = 0;
+      };
+
+    Shard& shard(uint32_t heapId, bool small) {
+      return shards[heapId%ShardHeaps][small ? 1 : 0];
+      }
+
+    Magazine& magazine() {
+      static std::atomic<uint32_t> counter{0};
+      static thread_local uint32_t id = counter.fetch_add(1,std::memory_order_relaxed);
+      return magazines[id%Magazines];
+      }
+
+    Allocation alloc(Shard& s, uint32_t blockSize, size_t size, size_t align, uint32_t heapId, uint32_t typeId, bool hostVisible) {
+      for(auto& i:s.pages){
+        if(i.heapId==heapId && i.allocated+blockSize<=i.allSize){
+          auto ret=i.alloc(blockSize,align,device);
+          if(ret.page!=nullptr) {
+            ret.size = size;
+            return ret;
+            }
+          }
+        }
+      return rawAlloc(s,blockSize,size,align,heapId,typeId,hostVisible,false);
+      }
+
+    Allocation rawAlloc(Shard& s, uint32_t blockSize, size_t size, size_t align,
+                        uint32_t heapId, uint32_t typeId, bool hostVisible, bool dedicated){
+      const uint32_t pgSize = (dedicated ? blockSize : std::max<uint32_t>(defPageSize,blockSize));
+      Memory         mem    = null;
+      {
+      std::lock_guard<std::mutex> guard(providerSync);
+      mem = device.alloc(pgSize,typeId);
+      }
+      if(mem==null)
         return Allocation();
       try {
-        pages.push_front(Page(0));
+        s.pages.emplace_front(pgSize);
         }
       catch(...){
-        device.free(pg.memory,pg.size,pg.typeId);
+        std::lock_guard<std::mutex> guard(providerSync);
+        device.free(mem,pgSize,typeId);
         throw;
         }
-      pages.front() = std::move(pg);
-      return pages.front().alloc(size,align,device);
+      Page& pg = s.pages.front();
+      pg.memory      = mem;
+      pg.typeId      = typeId;
+      pg.heapId      = heapId;
+      pg.hostVisible = hostVisible;
+      pg.shard       = &s;
+
+      auto ret = pg.alloc(blockSize,align,device);
+      if(ret.page==nullptr) {
+        // fresh page, that can't hold the request: don't keep it around empty
+        {
+        std::lock_guard<std::mutex> guard(providerSync);
+        device.free(mem,pgSize,typeId);
+        }
+        s.pages.pop_front();
+        return Allocation();
+        }
+      ret.size = size;
+      return ret;
       }
 
-    void       freeDevMemory(Memory mem){
-      return device.free(mem);
+    // returns cached small allocations of matching pages back to them
+    template<class Pred>
+    void flushMagazines(Pred pred) {
+      for(auto& m:magazines) {
+        Allocation spill[MagazineSize];
+        size_t     cnt = 0;
+        {
+        std::lock_guard<std::mutex> guard(m.sync);
+        for(size_t i=0; i<m.size;) {
+          if(pred(m.cache[i].page)) {
+            spill[cnt++] = m.cache[i];
+            m.cache[i]   = m.cache[--m.size];
+            } else {
+            ++i;
+            }
+          }
+        }
+        for(size_t i=0; i<cnt; ++i)
+          release(spill[i]);
+        }
+      }
+
+    void release(const Allocation& a) {
+      Shard& s = *a.page->shard;
+      std::lock_guard<std::mutex> guard(s.sync);
+      a.page->free(a);
+      if(a.page->allocated==0){
+        {
+        std::lock_guard<std::mutex> g(providerSync);
+        device.free(a.page->memory,a.page->size,a.page->typeId);
+        }
+        s.pages.remove_if([p=a.page](const Page& i){ return &i==p; });
+        }
       }
 
     MemoryProvider&         device;
-    std::mutex              sync;
-    std::forward_list<Page> pages;
+    // provider is not thread-safe, but it's only used to allocate whole pages
+    std::mutex              providerSync;
+    Shard                   shards[ShardHeaps][2];
+    Magazine                magazines[Magazines];
     uint32_t                defPageSize = DEFAULT_PAGE_SIZE;
   };
 
 template<class MemoryProvider>
 struct DeviceAllocator<MemoryProvider>::Block {
-  Block*   next  =nullptr;
-  uint32_t size  =0;
-  uint32_t offset=0;
+  // boundary tags: physical neighbours in page
+  Block*   prev     = nullptr;
+  Block*   next     = nullptr;
+  // list of free blocks of the same size class
+  Block*   prevFree = nullptr;
+  Block*   nextFree = nullptr;
+  uint32_t offset   = 0;
+  uint32_t size     = 0;
+  bool     free     = false;
   };
 
+// Two-level segregated fit: free blocks are binned by power of two (first level) and 16 linear steps
+// within it (second level); non-empty bins are tracked in bitmaps, so alloc and free are O(1).
 template<class MemoryProvider>
-struct DeviceAllocator<MemoryProvider>::Page : Block {
-  using    Block::next;
-  using    Block::size;
-  using    Block::offset;
+struct DeviceAllocator<MemoryProvider>::Page {
+  static constexpr uint32_t SlLog2  = 4;
+  static constexpr uint32_t SlCount = 1u<<SlLog2;
+  static constexpr uint32_t FlCount = 32-SlLog2+1;
 
   Memory     memory = null;
   std::mutex mmapSync;
   uint32_t   typeId      = 0;
   uint32_t   heapId      = 0;
+  uint32_t   size        = 0;
   uint32_t   allSize     = 0;
   uint32_t   allocated   = 0;
+  // allocations owned by users; doesn't count ones cached in magazines
+  std::atomic<uint32_t> live{0};
   bool       hostVisible = false;
-
-  Page(uint32_t sz) noexcept {
-    size   =sz;
-    allSize=sz;
+  Shard*     shard       = nullptr;
+
+  explicit Page(uint32_t sz) {
+    size    = sz;
+    allSize = sz;
+    if(!reserve(1))
+      throw std::bad_alloc();
+    Block* b = takeBlock();
+    b->size = sz;
+    insert(b);
     }
 
-  Page(Page&& p) noexcept {
-    std::swap(next,p.next);
-    size  =p.size;
-    offset=p.offset;
-    std::swap(memory,p.memory);
-    typeId      = p.typeId;
-    heapId      = p.heapId;
-    allSize     = p.allSize;
-    hostVisible = p.hostVisible;
-    }
+  Page(const Page&)=delete;
 
   ~Page(){
-    Block* b=next;
-    while(b!=nullptr){
-      Block* p=b->next;
-      delete b;
-      b=p;
+    while(chunks!=nullptr) {
+      Chunk* c = chunks->next;
+      delete chunks;
+      chunks = c;
       }
     }
 
-  Page& operator=(Page&& p) noexcept {
-    std::swap(next,p.next);
-    size  =p.size;
-    offset=p.offset;
-    std::swap(memory,p.memory);
-    typeId      = p.typeId;
-    heapId      = p.heapId;
-    allSize     = p.allSize;
-    hostVisible = p.hostVisible;
-    return *this;
-    }
-
   bool operator==(const Page& other) const noexcept {
     return memory==other.memory;
     }
 
-  Allocation alloc(size_t size,size_t align,MemoryProvider& /*prov*/) noexcept {
-    Block*   b=this;
-    while(b!=nullptr) {
-      if(size<=b->size) {
-        size_t padding=b->offset%align;
-        if(padding==0)
-          return alloc(*b,size);
-
-        padding=align-padding;
-        if(size+padding==b->size) {
-          return alloc(*b,size,padding);
-          } else
-        if(size+padding<b->size){
-          Block* bp=new(std::nothrow) Block();
-          if(bp!=nullptr){
-            bp->next=b->next;
-            b->next =bp;
-
-            bp->size  =uint32_t(b->size-padding);
-            bp->offset=uint32_t(b->offset+padding);
-            b->size   =uint32_t(padding);
-
-            return alloc(*bp,size);
-            }
-          }
-        }
-      b=b->next;
-      }
-    return Allocation{};
+  // smallest size of the size class, that holds 'sz'
+  static uint32_t roundUp(uint32_t sz) noexcept {
+    if(sz<SlCount)
+      return sz;
+    const uint32_t step = 1u<<(bitScanReverse(sz)-SlLog2);
+    return (sz+step-1) & ~(step-1);
     }
 
-  Allocation alloc(Block& b,size_t size) noexcept {
-    Allocation a;
-    a.offset=b.offset;
-    a.page  =this;
-    a.size  =size;
-
-    b.offset +=uint32_t(size);
-    b.size   -=uint32_t(size);
-    allocated+=uint32_t(size);
-    return a;
-    }
+  Allocation alloc(size_t size,size_t align,MemoryProvider& /*prov*/) noexcept {
+    if(size>allSize)
+      return Allocation{};
+    // block descriptors for alignment padding and tail
+    if(!reserve(2))
+      return Allocation{};
+
+    const uint32_t sz      = std::max<uint32_t>(uint32_t(size),1);
+    uint32_t       padding = 0;
+    Block*         b       = find(sz);
+    if(b!=nullptr)
+      padding = alignPadding(b->offset,align);
+    if((b==nullptr || b->size<sz+padding) && align>1) {
+      // worst case padding
+      if(uint64_t(sz)+align-1 > allSize)
+        return Allocation{};
+      b = find(uint32_t(sz+align-1));
+      if(b!=nullptr)
+        padding = alignPadding(b->offset,align);
+      }
+    if(b==nullptr)
+      return Allocation{};
+
+    remove(b);
+    if(padding>0) {
+      Block* r = split(b,padding);
+      insert(b);
+      b = r;
+      }
+    if(b->size>sz)
+      insert(split(b,sz));
 
-  Allocation alloc(Block& b,size_t size,size_t padding) noexcept {
     Allocation a;
-    a.offset=b.offset+padding;
-    a.page  =this;
-    a.size  =size;
-
-    uint32_t sz=uint32_t(size+padding);
-    b.offset +=sz;
-    b.size   -=sz;
-    allocated+=uint32_t(size);
+    a.page   = this;
+    a.offset = b->offset;
+    a.size   = size;
+    a.block  = b;
+    allocated += b->size;
+    live.fetch_add(1,std::memory_order_relaxed);
     return a;
     }
 
   void free(const Allocation& a) noexcept {
-    allocated -= uint32_t(a.size);
-
-    Block* b=this;
-    while(b!=nullptr && (b->offset+b->size)<a.offset)
-      b=b->next;
-
-    if(b->offset+b->size==a.offset){
-      b->size+=uint32_t(a.size);
-      mergeWithNext(b);
-      return;
-      }
-    if(b->offset==a.offset+a.size){
-      b->offset=uint32_t(a.offset);
-      b->size +=uint32_t(a.size);
-      return;
-      }
-
-    Block* r=new(std::nothrow) Block();
-    if(r==nullptr)
-      return; // no error, but sort of leak in Page
-    *r=*b;
-    b->next  =r;
-    b->size  =uint32_t(a.size);
-    b->offset=uint32_t(a.offset);
+    allocated -= a.block->size;
+
+    Block* b = a.block;
+    if(b->prev!=nullptr && b->prev->free) {
+      Block* p = b->prev;
+      remove(p);
+      merge(p,b);
+      b = p;
+      }
+    if(b->next!=nullptr && b->next->free) {
+      Block* n = b->next;
+      remove(n);
+      merge(b,n);
+      }
+    insert(b);
     }
 
-  void mergeWithNext(Block* b) noexcept {
-    while(b->next!=nullptr){
-      if(b->offset+b->size==b->next->offset){
-        auto rm=b->next;
-        b->size+=b->next->size;
-        b->next=b->next->next;
-        delete rm;
-        } else {
+  private:
+    struct Chunk {
+      Chunk* next = nullptr;
+      Block  block[64];
+      };
+
+    uint32_t flBits = 0;
+    uint32_t slBits[FlCount] = {};
+    Block*   bins[FlCount][SlCount] = {};
+    Chunk*   chunks     = nullptr;
+    Block*   spare      = nullptr; // unused descriptors, linked by 'next'
+    size_t   spareCount = 0;
+
+    static uint32_t alignPadding(uint32_t offset,size_t align) noexcept {
+      if(align<=1)
+        return 0;
+      const size_t m = offset%align;
+      return m==0 ? 0 : uint32_t(align-m);
+      }
+
+    static uint32_t bitScanReverse(uint32_t v) noexcept {
+#if defined(_MSC_VER)
+      unsigned long i = 0;
+      _BitScanReverse(&i,v);
+      return uint32_t(i);
+#else
+      return uint32_t(31-__builtin_clz(v));
+#endif
+      }
+
+    static uint32_t bitScanForward(uint32_t v) noexcept {
+#if defined(_MSC_VER)
+      unsigned long i = 0;
+      _BitScanForward(&i,v);
+      return uint32_t(i);
+#else
+      return uint32_t(__builtin_ctz(v));
+#endif
+      }
+
+    static void mapping(uint32_t sz,uint32_t& fl,uint32_t& sl) noexcept {
+      if(sz<SlCount) {
+        fl = 0;
+        sl = sz;
         return;
         }
+      const uint32_t msb = bitScanReverse(sz);
+      fl = msb-SlLog2+1;
+      sl = (sz>>(msb-SlLog2)) - SlCount;
+      }
+
+    Block* find(uint32_t sz) const noexcept {
+      uint32_t fl = 0, sl = 0;
+      if(sz<SlCount) {
+        mapping(sz,fl,sl);
+        return findClass(fl,sl);
+        }
+      // round up to next size class: any block of found bin is big enough
+      const uint64_t r = uint64_t(sz) + (1u<<(bitScanReverse(sz)-SlLog2)) - 1;
+      if(r<=0xFFFFFFFFu) {
+        mapping(uint32_t(r),fl,sl);
+        if(Block* b = findClass(fl,sl))
+          return b;
+        }
+      // bin of 'sz' itself may still have a big enough block (page of exactly requested size)
+      mapping(sz,fl,sl);
+      for(Block* b=bins[fl][sl]; b!=nullptr; b=b->nextFree)
+        if(b->size>=sz)
+          return b;
+      return nullptr;
+      }
+
+    // first block from bin (fl,sl) or any bigger one
+    Block* findClass(uint32_t fl, uint32_t sl) const noexcept {
+      uint32_t bits = slBits[fl] & (~0u << sl);
+      if(bits==0) {
+        const uint32_t fb = fl+1<FlCount ? (flBits & (~0u << (fl+1))) : 0;
+        if(fb==0)
+          return nullptr;
+        fl   = bitScanForward(fb);
+        bits = slBits[fl];
+        }
+      return bins[fl][bitScanForward(bits)];
+      }
+
+    void insert(Block* b) noexcept {
+      uint32_t fl = 0, sl = 0;
+      mapping(b->size,fl,sl);
+      b->free     = true;
+      b->prevFree = nullptr;
+      b->nextFree = bins[fl][sl];
+      if(b->nextFree!=nullptr)
+        b->nextFree->prevFree = b;
+      bins[fl][sl] = b;
+      flBits     |= (1u<<fl);
+      slBits[fl] |= (1u<<sl);
+      }
+
+    void remove(Block* b) noexcept {
+      uint32_t fl = 0, sl = 0;
+      mapping(b->size,fl,sl);
+      if(b->prevFree!=nullptr)
+        b->prevFree->nextFree = b->nextFree; else
+        bins[fl][sl] = b->nextFree;
+      if(b->nextFree!=nullptr)
+        b->nextFree->prevFree = b->prevFree;
+      if(bins[fl][sl]==nullptr) {
+        slBits[fl] &= ~(1u<<sl);
+        if(slBits[fl]==0)
+          flBits &= ~(1u<<fl);
+        }
+      b->free     = false;
+      b->prevFree = nullptr;
+      b->nextFree = nullptr;
+      }
+
+    // cuts [at,size) of 'b' into new block
+    Block* split(Block* b,uint32_t at) noexcept {
+      Block* r = takeBlock();
+      r->offset = b->offset+at;
+      r->size   = b->size-at;
+      r->prev   = b;
+      r->next   = b->next;
+      if(b->next!=nullptr)
+        b->next->prev = r;
+      b->next = r;
+      b->size = at;
+      return r;
+      }
+
+    // appends physically next 'n' to 'b'
+    void merge(Block* b,Block* n) noexcept {
+      b->size += n->size;
+      b->next  = n->next;
+      if(n->next!=nullptr)
+        n->next->prev = b;
+      giveBlock(n);
+      }
+
+    bool reserve(size_t n) noexcept {
+      if(spareCount>=n)
+        return true;
+      Chunk* c = new(std::nothrow) Chunk();
+      if(c==nullptr)
+        return false;
+      c->next = chunks;
+      chunks  = c;
+      for(auto& i:c->block)
+        giveBlock(&i);
+      return true;
+      }
+
+    Block* takeBlock() noexcept {
+      Block* b = spare;
+      spare = b->next;
+      --spareCount;
+      *b = Block();
+      return b;
+      }
+
+    void giveBlock(Block* b) noexcept {
+      b->next = spare;
+      spare   = b;
+      ++spareCount;
       }
-    }
   };
 }}
-
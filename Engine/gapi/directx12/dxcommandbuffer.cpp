@@ -1036,6 +1036,11 @@ void DxCommandBuffer::copy(AbstractGraphicsApi::Buffer& dstBuf, size_t offsetDes
 
 void DxCommandBuffer::copy(AbstractGraphicsApi::Texture& dstTex, size_t width, size_t height, size_t mip,
                            const AbstractGraphicsApi::Buffer& srcBuf, size_t offset) {
+  copy(dstTex,0,0,width,height,mip,srcBuf,offset);
+  }
+
+void DxCommandBuffer::copy(AbstractGraphicsApi::Texture& dstTex, size_t x, size_t y, size_t width, size_t height, size_t mip,
+                           const AbstractGraphicsApi::Buffer& srcBuf, size_t offset) {
   auto& dst = reinterpret_cast<DxTexture&>(dstTex);
   auto& src = reinterpret_cast<const DxBuffer&>(srcBuf);
 
@@ -1069,7 +1074,7 @@ void DxCommandBuffer::copy(AbstractGraphicsApi::Texture& dstTex, size_t width, s
 
   resState.onTranferUsage(src.nonUniqId, dst.nonUniqId, false);
   resState.flush(*this);
-  impl->CopyTextureRegion(&dstLoc, 0, 0, 0, &srcLoc, nullptr);
+  impl->CopyTextureRegion(&dstLoc, UINT(x), UINT(y), 0, &srcLoc, nullptr);
   }
 
 void DxCommandBuffer::fill(AbstractGraphicsApi::Texture& dstTex, uint32_t val) {
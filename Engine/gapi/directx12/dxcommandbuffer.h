@@ -81,6 +81,8 @@ class DxCommandBuffer:public AbstractGraphicsApi::CommandBuffer {
     void copyNative(AbstractGraphicsApi::Buffer& dest, size_t offset, const AbstractGraphicsApi::Texture& src, uint32_t width, uint32_t height, uint32_t mip);
     void copy(AbstractGraphicsApi::Buffer&  dest, size_t offsetDest, const AbstractGraphicsApi::Buffer& src, size_t offsetSrc, size_t size);
     void copy(AbstractGraphicsApi::Texture& dest, size_t width, size_t height, size_t mip, const AbstractGraphicsApi::Buffer&  src, size_t offset);
+    void copy(AbstractGraphicsApi::Texture& dest, size_t x, size_t y, size_t width, size_t height, size_t mip,
+              const AbstractGraphicsApi::Buffer& src, size_t offset);
 
     void fill(AbstractGraphicsApi::Texture& dest, uint32_t val);
 
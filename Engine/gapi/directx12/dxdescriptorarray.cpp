@@ -25,8 +25,8 @@ static int swizzle(ComponentSwizzle cs, int def) {
       return D3D12_SHADER_COMPONENT_MAPPING_FROM_MEMORY_COMPONENT_2;
     case ComponentSwizzle::A:
       return D3D12_SHADER_COMPONENT_MAPPING_FROM_MEMORY_COMPONENT_3;
-    //case ComponentSwizzle::One:
-    //  return D3D12_SHADER_COMPONENT_MAPPING_FORCE_VALUE_1;
+    case ComponentSwizzle::One:
+      return D3D12_SHADER_COMPONENT_MAPPING_FORCE_VALUE_1;
     }
   return def;
   }
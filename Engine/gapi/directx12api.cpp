@@ -405,6 +405,35 @@ void DirectX12Api::readBytes(AbstractGraphicsApi::Device*, AbstractGraphicsApi::
   buf->read(out,0,size);
   }
 
+void DirectX12Api::updateTexture(Device* d, PTexture t, const void* data, TextureFormat frm,
+                                 uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+  Detail::DxDevice& dx    = *reinterpret_cast<Detail::DxDevice*>(d);
+  uint32_t          row   = w*uint32_t(Pixmap::bppForFormat(frm));
+  const uint32_t    pith  = ((row+D3D12_TEXTURE_DATA_PITCH_ALIGNMENT-1)/D3D12_TEXTURE_DATA_PITCH_ALIGNMENT)*D3D12_TEXTURE_DATA_PITCH_ALIGNMENT;
+  Detail::DxBuffer  stage = dx.dataMgr().allocStagingMemory(nullptr,h*pith,MemUsage::TransferSrc,BufferHeap::Upload);
+
+  for(uint32_t i=0; i<h; ++i) {
+    auto px = reinterpret_cast<const uint8_t*>(data);
+    stage.update(px+i*row, i*pith, row);
+    }
+
+  Detail::DSharedPtr<Buffer*>  pstage(new Detail::DxBuffer(std::move(stage)));
+  Detail::DSharedPtr<Texture*> pbuf  (t.handler);
+
+  auto cmd = dx.dataMgr().get();
+  cmd->begin();
+  cmd->hold(pbuf);
+  cmd->hold(pstage); // preserve stage buffer, until gpu side copy is finished
+  // same queue as rendering: barrier waits for previously submitted reads of this texture
+  cmd->barrier(*pbuf.handler, ResourceAccess::Sampler, ResourceAccess::TransferDst, uint32_t(-1));
+  cmd->copy(*pbuf.handler,x,y,w,h,0,*pstage.handler,0);
+  cmd->barrier(*pbuf.handler, ResourceAccess::TransferDst, ResourceAccess::Sampler, uint32_t(-1));
+  cmd->end();
+
+  dx.dataMgr().waitFor(pbuf.handler); // write-after-write case
+  dx.dataMgr().submit(std::move(cmd));
+  }
+
 AbstractGraphicsApi::CommandBuffer* DirectX12Api::createCommandBuffer(Device* d) {
   Detail::DxDevice* dx = reinterpret_cast<Detail::DxDevice*>(d);
   return new DxCommandBuffer(*dx);
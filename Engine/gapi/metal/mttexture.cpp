@@ -23,6 +23,8 @@ static MTL::TextureSwizzle swizzle(ComponentSwizzle cs, MTL::TextureSwizzle def)
       return MTL::TextureSwizzleBlue;
     case ComponentSwizzle::A:
       return MTL::TextureSwizzleAlpha;
+    case ComponentSwizzle::One:
+      return MTL::TextureSwizzleOne;
     }
   return def;
   }
@@ -149,6 +151,25 @@ uint32_t MtTexture::mipCount() const {
   return mipCnt;
   }
 
+void MtTexture::update(const void* data, TextureFormat frm, uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+#ifdef __IOS__
+  const MTL::StorageMode smode = MTL::StorageModeShared;
+#else
+  const MTL::StorageMode smode = MTL::StorageModeManaged;
+#endif
+  NsPtr<MTL::Texture> stage = alloc(frm,w,h,1,1,smode,MTL::TextureUsageShaderRead);
+  stage->replaceRegion(MTL::Region(0,0,w,h), 0, data, w*Pixmap::bppForFormat(frm));
+
+  auto pool = NsPtr<NS::AutoreleasePool>::init();
+  auto cmd  = dev.queue->commandBuffer();
+  auto enc  = cmd->blitCommandEncoder();
+  enc->copyFromTexture(stage.get(),0,0,MTL::Origin(0,0,0),MTL::Size(w,h,1),
+                       impl.get(),0,0,MTL::Origin(x,y,0));
+  enc->endEncoding();
+  // hazards are tracked by metal, command buffer retains stage texture until copy is finished
+  cmd->commit();
+  }
+
 void MtTexture::readPixels(Pixmap& out, TextureFormat frm, const uint32_t w, const uint32_t h, uint32_t mip) {
   size_t bpp = Pixmap::bppForFormat(frm);
   if(bpp==0)
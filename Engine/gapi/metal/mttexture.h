@@ -20,6 +20,8 @@ class MtTexture : public Tempest::AbstractGraphicsApi::Texture {
     uint32_t mipCount() const override;
     void     readPixels(Pixmap& out, TextureFormat frm,
                         const uint32_t w, const uint32_t h, uint32_t mip);
+    void     update(const void* data, TextureFormat frm,
+                    uint32_t x, uint32_t y, uint32_t w, uint32_t h);
 
     uint32_t bitCount();
 
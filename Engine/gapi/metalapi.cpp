@@ -182,6 +182,12 @@ void MetalApi::readBytes(AbstractGraphicsApi::Device*, AbstractGraphicsApi::Buff
   buf->read(out,0,size);
   }
 
+void MetalApi::updateTexture(AbstractGraphicsApi::Device*, PTexture t, const void* data, TextureFormat frm,
+                             uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+  auto& tx = *reinterpret_cast<MtTexture*>(t.handler);
+  tx.update(data,frm,x,y,w,h);
+  }
+
 AbstractGraphicsApi::Desc *MetalApi::createDescriptors(AbstractGraphicsApi::Device* d,
                                                        AbstractGraphicsApi::PipelineLay& layP) {
   auto& dev = *reinterpret_cast<MtDevice*>(d);
@@ -40,6 +40,8 @@ class MetalApi : public AbstractGraphicsApi {
     void           readPixels(Device *d, Pixmap &out, const PTexture t,
                               TextureFormat frm, const uint32_t w, const uint32_t h, uint32_t mip, bool storageImg) override;
     void           readBytes(Device* d, Buffer* buf, void* out, size_t size) override;
+    void           updateTexture(Device* d, PTexture t, const void* data, TextureFormat frm,
+                                 uint32_t x, uint32_t y, uint32_t w, uint32_t h) override;
 
     Desc*          createDescriptors(Device* d, PipelineLay& layP) override;
 
@@ -7,6 +7,9 @@
 #include <cstddef>
 #include <atomic>
 #include <memory>
+#include <algorithm>
+#include <mutex>
+#include <new>
 
 namespace Tempest {
 
@@ -21,60 +24,71 @@ class RectAllocator {
   public:
     using Memory=typename MemoryProvider::DeviceMemory;
 
-    explicit RectAllocator(MemoryProvider& device):device(device){}
+    // how free space of a page is searched and split
+    enum Policy : uint8_t {
+      Guillotine, // recursive split, first fit
+      Skyline,    // bottom-left skyline, good for rows of similar height (glyphs)
+      MaxRects,   // maximal rectangles, best short side fit; best occupancy for mixed sizes
+      };
+
+    explicit RectAllocator(MemoryProvider& device, Policy policy=Guillotine):device(device),policy(policy){}
 
     RectAllocator(const RectAllocator&)=delete;
     ~RectAllocator(){}
 
+    // size of new pages; allocations bigger than that get a page of their own size
+    void setPageSize(uint32_t sz) {
+      std::lock_guard<std::mutex> guard(sync);
+      defPageSize = std::max<uint32_t>(sz,1);
+      }
+
+    uint32_t pageSize() const { return defPageSize; }
+
     struct Allocation {
       Allocation()=default;
 
       Allocation(Allocation&& a)
-        :owner(a.owner),node(a.node),pId(a.pId){
+        :owner(a.owner),node(a.node){
         a.owner=nullptr;
         a.node =nullptr;
-        a.pId  =0;
         }
 
-      Allocation(const Allocation& a):owner(a.owner),node(a.node),pId(a.pId) {
+      Allocation(const Allocation& a):owner(a.owner),node(a.node) {
         if(node!=nullptr)
           node->addref();
         }
 
       ~Allocation(){
         if(node!=nullptr)
-          node->decref();
+          owner->free(node);
         }
 
       Allocation& operator=(const Allocation& a){
         if(a.node!=nullptr)
           a.node->addref();
         if(node!=nullptr)
-          node->decref();
+          owner->free(node);
         owner=a.owner;
         node =a.node;
-        pId  =a.pId;
         return *this;
         }
 
       Allocation& operator=(Allocation&& a){
         std::swap(owner,a.owner);
         std::swap(node ,a.node);
-        std::swap(pId  ,a.pId);
         return *this;
         }
 
       Memory& memory(){
-        return owner->pages[pId].memory;
+        return node->page->memory;
         }
 
       const Memory& memory() const {
-        return owner->pages[pId].memory;
+        return node->page->memory;
         }
 
       Rect pageRect() const {
-        auto& p=owner->pages[pId];
-        return Rect(int(node->x),int(node->y),int(p.root->w),int(p.root->h));
+        return Rect(int(node->x),int(node->y),int(node->page->w),int(node->page->h));
         }
 
       Point pos() const {
@@ -82,44 +96,191 @@ class RectAllocator {
         }
 
       void* pageId() const {
-        return owner==nullptr ? nullptr : &owner->pages[pId];
+        return node!=nullptr ? node->page : nullptr;
+        }
+
+      // holds allocator lock: page content and placement don't change until it's released
+      std::unique_lock<std::mutex> lock() const {
+        return std::unique_lock<std::mutex>(owner->sync);
         }
 
       RectAllocator* owner=nullptr;
+      // placement is read through the node: compact() may move it to another page
       Node*          node =nullptr;
-      size_t         pId  =0;
       };
 
     Allocation alloc(uint32_t iw,uint32_t ih) {
+      return alloc(iw,ih,[](Memory&,const Point&){});
+      }
+
+    // fill(memory,pos) writes content of new allocation; it's called under allocator lock (must not throw),
+    // so compact() never moves allocation, which is not filled yet
+    template<class Fn>
+    Allocation alloc(uint32_t iw,uint32_t ih,Fn fill) {
       if(iw==0 || ih==0)
         return Allocation();
 
-      for(size_t i=0;i<pages.size();++i){
-        auto a=alloc(pages[i],i,iw,ih);
-        if(a.owner)
-          return a;
+      std::lock_guard<std::mutex> guard(sync);
+      Allocation a = implAlloc(iw,ih);
+      fill(a.memory(),a.pos());
+      return a;
+      }
+
+    // Moves allocations with single owner out of sparse pages, then releases pages without allocations.
+    // Pages smaller than current page size are collapsed into a new page, if there are more than one of them.
+    // Allocations, that are shared (e.g. recorded in a painted image), stay in place; Guillotine pages are only released.
+    // move(srcMemory,srcRect,dstMemory,dstX,dstY) copies content, it's called under allocator lock.
+    // Returns by how many pages the atlas got smaller.
+    template<class Fn>
+    size_t compact(Fn move) {
+      std::lock_guard<std::mutex> guard(sync);
+      const size_t count = pages.size();
+      if(policy!=Guillotine) {
+        std::vector<Page*> order(pages.size());
+        for(size_t i=0; i<pages.size(); ++i)
+          order[i] = pages[i].get();
+        std::sort(order.begin(),order.end(),[](const Page* a,const Page* b){
+          return a->area*uint64_t(b->w)*b->h < b->area*uint64_t(a->w)*a->h;
+          });
+        size_t small = 0, movable = 0;
+        for(auto p:order)
+          if(p->w<defPageSize || p->h<defPageSize) {
+            ++small;
+            if(p->nodes!=nullptr && isMovable(*p))
+              ++movable;
+            }
+        // merge page is opened only, if some of small pages can actually go there
+        if(small>1 && movable>0) {
+          pages.emplace_back(new Page(*this,defPageSize,defPageSize));
+          order.push_back(pages.back().get());
+          }
+        // sparse pages are moved into denser ones, never other way
+        for(size_t i=0; i<order.size(); ++i)
+          evacuate(*order[i],order.data()+i+1,order.size()-i-1,move);
+        }
+
+      for(size_t i=0; i<pages.size();) {
+        if(pages[i]->isEmpty())
+          pages.erase(pages.begin()+ptrdiff_t(i)); else
+          ++i;
+        }
+      return count-pages.size();
+      }
+
+  private:
+    MemoryProvider&                    device;
+    const Policy                       policy;
+    // pages are never moved: allocations from other threads refer to them directly;
+    // pages are only released by compact()
+    std::vector<std::unique_ptr<Page>> pages;
+    uint32_t                           defPageSize=512;
+    std::mutex                         sync;
+
+    Allocation implAlloc(uint32_t iw,uint32_t ih) {
+      if(policy==Guillotine) {
+        for(auto& p:pages){
+          auto a=alloc(*p,iw,ih);
+          if(a.owner)
+            return a;
+          }
+        } else {
+        // best fit over all pages, not first fit: keeps pages dense
+        Page* best = nullptr;
+        Fit   fit;
+        for(auto& p:pages) {
+          Fit f = p->fit(iw,ih);
+          if(f.better(fit)) {
+            fit  = f;
+            best = p.get();
+            }
+          }
+        if(best!=nullptr)
+          return emplace(*best,fit,iw,ih);
         }
       const uint32_t w=std::max(iw,defPageSize);
       const uint32_t h=std::max(ih,defPageSize);
 
-      pages.emplace_back(*this,w,h);
-      auto a=alloc(pages.back(),pages.size()-1,iw,ih);
-      if(a.owner)
-        return a;
+      pages.emplace_back(new Page(*this,w,h));
+      if(policy!=Guillotine) {
+        Page& p = *pages.back();
+        Fit   f = p.fit(iw,ih);
+        if(f.isValid())
+          return emplace(p,f,iw,ih);
+        } else {
+        auto a=alloc(*pages.back(),iw,ih);
+        if(a.owner)
+          return a;
+        }
       pages.pop_back();
       throw std::bad_alloc();
       }
 
-  private:
-    MemoryProvider&   device;
-    std::vector<Page> pages;
-    uint32_t          defPageSize=512; //TODO: get-set
+    void free(Node* n) {
+      // tree is modified on last release, so it has to be serialized with alloc
+      std::lock_guard<std::mutex> guard(sync);
+      if(policy==Guillotine) {
+        n->decref();
+        return;
+        }
+      if(n->refcount.fetch_sub(1,std::memory_order_acq_rel)!=1)
+        return;
+      n->page->unlink(*n);
+      n->page->release(*n);
+      delete n;
+      }
+
+    // shared allocations can't be moved transparently
+    static bool isMovable(const Page& pg) {
+      for(Node* n=pg.nodes; n!=nullptr; n=n->next)
+        if(n->refcount.load(std::memory_order_acquire)!=1)
+          return false;
+      return true;
+      }
+
+    template<class Fn>
+    void evacuate(Page& src,Page** dst,size_t dstCount,Fn& move) {
+      if(!isMovable(src))
+        return;
+      std::vector<Node*> nodes;
+      for(Node* n=src.nodes; n!=nullptr; n=n->next)
+        nodes.push_back(n);
+      // largest first, for better packing
+      std::sort(nodes.begin(),nodes.end(),[](const Node* a,const Node* b){
+        return uint64_t(a->w)*a->h > uint64_t(b->w)*b->h;
+        });
+
+      for(auto n:nodes) {
+        Page* best = nullptr;
+        Fit   fit;
+        for(size_t i=0; i<dstCount; ++i) {
+          Fit f = dst[i]->fit(n->w,n->h);
+          if(f.better(fit)) {
+            fit  = f;
+            best = dst[i];
+            }
+          }
+        if(best==nullptr)
+          return;
+
+        best->place(fit,n->w,n->h);
+        move(src.memory,Rect(int(n->x),int(n->y),int(n->w),int(n->h)),best->memory,fit.x,fit.y);
+        src.unlink(*n);
+        src.release(*n);
+
+        n->x    = fit.x;
+        n->y    = fit.y;
+        n->page = best;
+        best->link(*n);
+        }
+      }
 
     struct Node {
       Node()=default;
       Node(uint32_t x,uint32_t y,uint32_t w,uint32_t h,Node* owner):x(x),y(y),w(w),h(h),owner(owner){}
+      ~Node(){ clear(); }
 
       std::atomic<uint32_t> refcount{};
+      Page*                 page=nullptr;
 
       uint32_t x=0;
       uint32_t y=0;
@@ -146,66 +307,331 @@ class RectAllocator {
 
       Node*    owner=nullptr;
       Node*    sub[3]={};
-
-      void     remove(Node* n){
-        if(sub[0]==n)
-          sub[0]=nullptr;
-        else if(sub[1]==n)
-          sub[1]=nullptr;
-        else if(sub[2]==n)
-          sub[2]=nullptr;
+      // list of allocations in page (Skyline and MaxRects)
+      Node*    prev=nullptr;
+      Node*    next=nullptr;
+
+      void     clear(){
+        for(auto& i:sub) {
+          delete i;
+          i = nullptr;
+          }
         }
 
       bool hasLeafs() const {
         return sub[0]!=nullptr || sub[1]!=nullptr || sub[2]!=nullptr;
         }
 
+      bool isFree() const {
+        return refcount.load(std::memory_order_acquire)==0 && !hasLeafs();
+        }
+
       void addref() {
         refcount.fetch_add(1,std::memory_order_acq_rel);
         }
 
       void decref() {
-        Node* nx=this;
-        if(nx->refcount.fetch_sub(1,std::memory_order_acq_rel)!=1)
+        if(refcount.fetch_sub(1,std::memory_order_acq_rel)!=1)
           return;
-
-        Node* ow=nx->owner;
-        while(true) {
-          ow->remove(nx);
-          nx=ow;
-          if(nx==nullptr || nx->hasLeafs())
-            return;
-          ow = nx->owner;
+        // node is free leaf again: merge splits, where every part is free
+        for(Node* nx=owner; nx!=nullptr; nx=nx->owner) {
+          for(auto i:nx->sub)
+            if(i!=nullptr && !i->isFree())
+              return;
+          nx->clear();
           }
-        delete this;
         }
 
       Point pos() const { return Point(x,y); }
       };
 
+    struct Area {
+      uint32_t x=0, y=0, w=0, h=0;
+
+      bool contains(const Area& a) const {
+        return x<=a.x && y<=a.y && a.x+a.w<=x+w && a.y+a.h<=y+h;
+        }
+
+      bool intersects(const Area& a) const {
+        return a.x<x+w && x<a.x+a.w && a.y<y+h && y<a.y+a.h;
+        }
+      };
+
+    // horizontal segment of skyline: [x,x+w) is occupied from 0 to y
+    struct Span {
+      uint32_t x=0, y=0, w=0;
+      };
+
+    // placement candidate, lower score is better
+    struct Fit {
+      uint32_t x=0, y=0;
+      uint32_t score0=uint32_t(-1);
+      uint32_t score1=uint32_t(-1);
+      size_t   id    =0;     // skyline span or free area
+      bool     free  =false; // skyline: placed into released or wasted area
+
+      bool isValid() const { return score0!=uint32_t(-1); }
+
+      bool better(const Fit& f) const {
+        if(score0!=f.score0)
+          return score0<f.score0;
+        return score1<f.score1;
+        }
+      };
+
     struct Page {
       Page(RectAllocator& owner,uint32_t w,uint32_t h)
-        :owner(owner),root(new Node(0,0,w,h,nullptr)) {
+        :owner(owner),policy(owner.policy),w(w),h(h) {
+        if(policy==Guillotine)
+          root.reset(new Node(0,0,w,h,nullptr));
+        reset();
         memory = owner.device.alloc(w,h);// std::bad_alloc, if error
         }
 
-      Page(Page&&)=default;
-
       ~Page(){
         // memory!=null; 100%!!
         owner.device.free(memory);
         }
 
       RectAllocator&        owner;
+      const Policy          policy;
+      const uint32_t        w=0, h=0;
       std::unique_ptr<Node> root;
+      std::vector<Span>     skyline;
+      // MaxRects: maximal free rectangles (may overlap)
+      // Skyline:  released areas and holes below skyline (disjoint)
+      std::vector<Area>     freeArea;
+      Node*                 nodes=nullptr;
+      uint32_t              live=0;
+      uint64_t              area=0;
       Memory                memory={};
+
+      bool isEmpty() const {
+        return policy==Guillotine ? root->isFree() : live==0;
+        }
+
+      void link(Node& n) {
+        n.prev = nullptr;
+        n.next = nodes;
+        if(nodes!=nullptr)
+          nodes->prev = &n;
+        nodes = &n;
+        }
+
+      void unlink(Node& n) {
+        if(n.prev!=nullptr)
+          n.prev->next = n.next; else
+          nodes = n.next;
+        if(n.next!=nullptr)
+          n.next->prev = n.prev;
+        n.prev = nullptr;
+        n.next = nullptr;
+        }
+
+      Fit fit(uint32_t pw,uint32_t ph) const {
+        return policy==Skyline ? fitSkyline(pw,ph) : fitMaxRects(pw,ph);
+        }
+
+      void reset() {
+        skyline.clear();
+        freeArea.clear();
+        if(policy==Skyline)
+          skyline.push_back(Span{0,0,w});
+        if(policy==MaxRects)
+          freeArea.push_back(Area{0,0,w,h});
+        }
+
+      Fit fitFreeArea(uint32_t pw,uint32_t ph) const {
+        // best short side fit
+        Fit ret;
+        for(size_t i=0;i<freeArea.size();++i) {
+          auto& a = freeArea[i];
+          if(a.w<pw || a.h<ph)
+            continue;
+          const uint32_t dw = a.w-pw;
+          const uint32_t dh = a.h-ph;
+          Fit f = {a.x,a.y,std::min(dw,dh),std::max(dw,dh),i,true};
+          if(f.better(ret))
+            ret = f;
+          }
+        return ret;
+        }
+
+      Fit fitMaxRects(uint32_t pw,uint32_t ph) const {
+        return fitFreeArea(pw,ph);
+        }
+
+      Fit fitSkyline(uint32_t pw,uint32_t ph) const {
+        Fit ret = fitFreeArea(pw,ph);
+        if(ret.isValid()) {
+          // holes never grow the skyline - always preferred
+          ret.score0 = 0;
+          return ret;
+          }
+        for(size_t i=0;i<skyline.size();++i) {
+          uint32_t y = 0;
+          if(!skylineTop(i,pw,ph,y))
+            continue;
+          // bottom-left: lowest top edge, then leftmost
+          Fit f = {skyline[i].x,y,y+ph,skyline[i].x,i,false};
+          if(f.better(ret))
+            ret = f;
+          }
+        return ret;
+        }
+
+      bool skylineTop(size_t i,uint32_t pw,uint32_t ph,uint32_t& y) const {
+        if(skyline[i].x+pw>w)
+          return false;
+        // spans cover [0,w) without gaps
+        y = 0;
+        for(uint32_t left=pw; left>0; ++i) {
+          y = std::max(y,skyline[i].y);
+          if(y+ph>h)
+            return false;
+          left -= std::min(left,skyline[i].w);
+          }
+        return true;
+        }
+
+      void place(const Fit& f,uint32_t pw,uint32_t ph) {
+        ++live;
+        area += uint64_t(pw)*ph;
+        if(policy==MaxRects)
+          placeMaxRects(Area{f.x,f.y,pw,ph}); else
+        if(f.free)
+          placeFreeArea(f.id,pw,ph); else
+          placeSkyline(f.id,f.y,pw,ph);
+        }
+
+      void placeSkyline(size_t i,uint32_t y,uint32_t pw,uint32_t ph) {
+        const uint32_t x = skyline[i].x;
+        // remember holes under the new rect
+        for(size_t r=i; r<skyline.size() && skyline[r].x<x+pw; ++r) {
+          auto& s = skyline[r];
+          if(s.y<y)
+            freeArea.push_back(Area{s.x,s.y,std::min(s.x+s.w,x+pw)-s.x,y-s.y});
+          }
+
+        skyline.insert(skyline.begin()+ptrdiff_t(i),Span{x,y+ph,pw});
+        size_t r = i+1;
+        while(r<skyline.size() && skyline[r].x<x+pw) {
+          auto&          s   = skyline[r];
+          const uint32_t cut = x+pw-s.x;
+          if(cut<s.w) {
+            s.x += cut;
+            s.w -= cut;
+            break;
+            }
+          skyline.erase(skyline.begin()+ptrdiff_t(r));
+          }
+
+        for(size_t r=1; r<skyline.size();) {
+          if(skyline[r-1].y==skyline[r].y) {
+            skyline[r-1].w += skyline[r].w;
+            skyline.erase(skyline.begin()+ptrdiff_t(r));
+            } else {
+            ++r;
+            }
+          }
+        }
+
+      void placeFreeArea(size_t i,uint32_t pw,uint32_t ph) {
+        const Area a = freeArea[i];
+        freeArea[i] = freeArea.back();
+        freeArea.pop_back();
+
+        // split along shorter leftover axis
+        const uint32_t dw = a.w-pw;
+        const uint32_t dh = a.h-ph;
+        Area right, bottom;
+        if(dw<dh) {
+          right  = Area{a.x+pw,a.y,   dw, ph};
+          bottom = Area{a.x,   a.y+ph,a.w,dh};
+          } else {
+          right  = Area{a.x+pw,a.y,   dw, a.h};
+          bottom = Area{a.x,   a.y+ph,pw, dh};
+          }
+        if(right.w>0 && right.h>0)
+          freeArea.push_back(right);
+        if(bottom.w>0 && bottom.h>0)
+          freeArea.push_back(bottom);
+        }
+
+      void placeMaxRects(const Area& r) {
+        const size_t size = freeArea.size();
+        for(size_t i=0; i<size; ++i) {
+          const Area a = freeArea[i];
+          if(!a.intersects(r))
+            continue;
+          if(r.x>a.x)
+            freeArea.push_back(Area{a.x,a.y,r.x-a.x,a.h});
+          if(r.x+r.w<a.x+a.w)
+            freeArea.push_back(Area{r.x+r.w,a.y,a.x+a.w-r.x-r.w,a.h});
+          if(r.y>a.y)
+            freeArea.push_back(Area{a.x,a.y,a.w,r.y-a.y});
+          if(r.y+r.h<a.y+a.h)
+            freeArea.push_back(Area{a.x,r.y+r.h,a.w,a.y+a.h-r.y-r.h});
+          freeArea[i].w = 0;
+          }
+        prune(size);
+        }
+
+      // removes empty and non-maximal areas; areas before 'fresh' are known to not contain each other
+      void prune(size_t fresh) {
+        for(size_t i=0; i<freeArea.size(); ++i) {
+          auto& a = freeArea[i];
+          if(a.w==0)
+            continue;
+          const size_t j0 = i<fresh ? fresh : 0;
+          for(size_t j=j0; j<freeArea.size(); ++j) {
+            if(i!=j && freeArea[j].w!=0 && freeArea[j].contains(a)) {
+              a.w = 0;
+              break;
+              }
+            }
+          }
+        freeArea.erase(std::remove_if(freeArea.begin(),freeArea.end(),[](const Area& a){ return a.w==0; }),
+                       freeArea.end());
+        }
+
+      void release(const Node& n) {
+        area -= uint64_t(n.w)*n.h;
+        if(--live==0) {
+          reset();
+          return;
+          }
+        // grow released area over free neighbours with the same edge
+        Area a = {n.x,n.y,n.w,n.h};
+        for(size_t i=0; i<freeArea.size();) {
+          const Area& f = freeArea[i];
+          if(f.y==a.y && f.h==a.h && (f.x+f.w==a.x || a.x+a.w==f.x)) {
+            a.x  = std::min(a.x,f.x);
+            a.w += f.w;
+            }
+          else if(f.x==a.x && f.w==a.w && (f.y+f.h==a.y || a.y+a.h==f.y)) {
+            a.y  = std::min(a.y,f.y);
+            a.h += f.h;
+            }
+          else {
+            ++i;
+            continue;
+            }
+          freeArea[i] = freeArea.back();
+          freeArea.pop_back();
+          i = 0;
+          }
+        freeArea.push_back(a);
+        if(policy==MaxRects)
+          prune(freeArea.size()-1);
+        }
       };
 
-    Allocation alloc(Page& p,size_t page,uint32_t pw,uint32_t ph) {
-      return alloc(*p.root,page,pw,ph);
+    Allocation alloc(Page& p,uint32_t pw,uint32_t ph) {
+      return alloc(*p.root,p,pw,ph);
       }
 
-    Allocation alloc(Node& n,size_t page,uint32_t pw,uint32_t ph){
+    Allocation alloc(Node& n,Page& page,uint32_t pw,uint32_t ph){
       if(n.refcount.load(std::memory_order_acquire)>0)
         return Allocation();
 
@@ -271,87 +697,173 @@ class RectAllocator {
       return Allocation();
       }
 
-    Allocation emplace(Node* nx,size_t page) {
+    Allocation emplace(Page& page,const Fit& f,uint32_t pw,uint32_t ph) {
+      std::unique_ptr<Node> nx(new Node(f.x,f.y,pw,ph,nullptr));
+      page.place(f,pw,ph);
+      page.link(*nx);
+      return emplace(nx.release(),page);
+      }
+
+    Allocation emplace(Node* nx,Page& page) {
+      nx->page = &page;
+
       Allocation a;
       a.owner = this;
       a.node  = nx;
-      a.pId   = page;
 
       nx->addref();
       return a;
       }
 
+    // Slab allocator: blocks are aligned to their size, so block of a slot is found from its address.
+    // Blocks with free slots are kept in a list, each thread keeps a small cache of slots.
+    // Single instance per T is expected, since thread cache is shared.
     template<class T>
-    struct Block {
-      Block*                next=nullptr;
-      std::atomic<uint32_t> mask{};
-      T                     val[32]={};
+    struct Allocator {
+      static constexpr size_t BlockSize = 4096;
+      static constexpr size_t CacheSize = 32;
+
+      union Slot {
+        Slot* next;
+        alignas(T) unsigned char val[sizeof(T)];
+        };
+
+      struct Block {
+        Block*   prev   = nullptr;
+        Block*   next   = nullptr;
+        Slot*    free   = nullptr;
+        uint32_t used   = 0;
+        uint32_t bump   = 0;     // slots starting from bump are never used yet
+        bool     listed = false;
+        };
+
+      struct Cache {
+        explicit Cache(Allocator& owner):owner(owner){}
+        ~Cache(){ owner.release(slot,size); }
+
+        Allocator& owner;
+        Slot*      slot[CacheSize] = {};
+        size_t     size = 0;
+        };
+
+      static constexpr size_t   HeaderSize = (sizeof(Block)+alignof(Slot)-1)/alignof(Slot)*alignof(Slot);
+      static constexpr uint32_t Capacity   = uint32_t((BlockSize-HeaderSize)/sizeof(Slot));
+      static_assert(Capacity>=CacheSize, "block is too small");
+
+      std::mutex sync;
+      Block*     partial = nullptr;
+
+      ~Allocator(){
+        // blocks with live slots are left as is
+        while(partial!=nullptr) {
+          Block* b = partial;
+          unlink(*b);
+          if(b->used==0)
+            destroy(b);
+          }
+        }
 
       T* alloc() noexcept {
-        uint32_t v = mask.load(std::memory_order_acquire);
-        for(uint32_t i=0;i<32;){
-          uint32_t id=(1<<i);
-          if((v&id) == 0) {
-            if(mask.compare_exchange_strong(v,(v|id),std::memory_order_acq_rel,std::memory_order_acquire)) {
-              return &val[i];
-              }
+        Cache& c = cache();
+        if(c.size==0)
+          c.size = acquire(c.slot,CacheSize/2);
+        if(c.size==0)
+          return nullptr;
+        return reinterpret_cast<T*>(c.slot[--c.size]);
+        }
+
+      void free(T* ptr) noexcept {
+        Cache& c = cache();
+        if(c.size==CacheSize) {
+          release(c.slot+CacheSize/2,CacheSize/2);
+          c.size = CacheSize/2;
+          }
+        c.slot[c.size++] = reinterpret_cast<Slot*>(ptr);
+        }
+
+      Cache& cache() {
+        static thread_local Cache c(*this);
+        return c;
+        }
+
+      size_t acquire(Slot** out,size_t count) noexcept {
+        std::lock_guard<std::mutex> guard(sync);
+        size_t n = 0;
+        while(n<count) {
+          if(partial==nullptr && !grow())
+            break;
+          Block& b = *partial;
+          if(b.free!=nullptr) {
+            out[n] = b.free;
+            b.free = b.free->next;
             } else {
-            ++i;
-            continue;
+            out[n] = slots(b)+b.bump;
+            ++b.bump;
             }
+          ++n;
+          ++b.used;
+          if(b.used==Capacity)
+            unlink(b);
           }
-        return nullptr;
+        return n;
         }
 
-      bool free(T* t) noexcept {
-        if(t<val)
-          return false;
-        ptrdiff_t i=t-val;
-        if(i>=32)
+      void release(Slot** s,size_t count) noexcept {
+        std::lock_guard<std::mutex> guard(sync);
+        for(size_t i=0; i<count; ++i) {
+          Block& b = blockOf(s[i]);
+          s[i]->next = b.free;
+          b.free     = s[i];
+          if(!b.listed)
+            link(b);
+          --b.used;
+          // keep last block to avoid ping-pong on alloc/free
+          if(b.used==0 && (b.prev!=nullptr || b.next!=nullptr)) {
+            unlink(b);
+            destroy(&b);
+            }
+          }
+        }
+
+      bool grow() noexcept {
+        void* mem = ::operator new(BlockSize,std::align_val_t(BlockSize),std::nothrow);
+        if(mem==nullptr)
           return false;
-        uint32_t id=(1<<i);
-        mask.fetch_and(~id,std::memory_order_release);
+        link(*new(mem) Block());
         return true;
         }
-      };
 
-    template<class T>
-    struct Allocator {
-      Block<T> node;
+      void destroy(Block* b) noexcept {
+        b->~Block();
+        ::operator delete(b,std::align_val_t(BlockSize));
+        }
 
-      ~Allocator(){
-        Block<T>* cur=node.next;
-        while( cur!=nullptr ) {
-          auto p = cur->next;
-          delete cur;
-          cur=p;
-          }
+      void link(Block& b) noexcept {
+        b.prev   = nullptr;
+        b.next   = partial;
+        b.listed = true;
+        if(partial!=nullptr)
+          partial->prev = &b;
+        partial = &b;
         }
 
-      T* alloc() noexcept {
-        Block<T>* cur=&node;
-        while( true ) {
-          if(T* ptr=cur->alloc())
-            return ptr;
-          if(cur->next==nullptr) {
-            auto p=new(std::nothrow) Block<T>();
-            if(p==nullptr)
-              return nullptr;
-            cur->next=p;
-            return cur->next->alloc();
-            } else {
-            cur=cur->next;
-            }
-          }
+      void unlink(Block& b) noexcept {
+        if(b.prev!=nullptr)
+          b.prev->next = b.next; else
+          partial = b.next;
+        if(b.next!=nullptr)
+          b.next->prev = b.prev;
+        b.prev   = nullptr;
+        b.next   = nullptr;
+        b.listed = false;
         }
 
-      void free(T* ptr) noexcept {
-        Block<T>* cur=&node;
-        while( cur!=nullptr ) {
-          if(cur->free(ptr))
-            return;
-          cur=cur->next;
-          }
+      static Slot* slots(Block& b) noexcept {
+        return reinterpret_cast<Slot*>(reinterpret_cast<uint8_t*>(&b)+HeaderSize);
+        }
+
+      static Block& blockOf(void* ptr) noexcept {
+        return *reinterpret_cast<Block*>(reinterpret_cast<uintptr_t>(ptr) & ~uintptr_t(BlockSize-1));
         }
       };
   };
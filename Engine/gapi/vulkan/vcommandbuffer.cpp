@@ -654,6 +654,11 @@ void VCommandBuffer::fill(AbstractGraphicsApi::Buffer& dstBuf, size_t offsetDest
 
 void VCommandBuffer::copy(AbstractGraphicsApi::Texture& dstTex, size_t width, size_t height, size_t mip,
                           const AbstractGraphicsApi::Buffer& srcBuf, size_t offset) {
+  copy(dstTex,0,0,width,height,mip,srcBuf,offset);
+  }
+
+void VCommandBuffer::copy(AbstractGraphicsApi::Texture& dstTex, size_t x, size_t y, size_t width, size_t height, size_t mip,
+                          const AbstractGraphicsApi::Buffer& srcBuf, size_t offset) {
   auto& src = reinterpret_cast<const VBuffer&>(srcBuf);
   auto& dst = reinterpret_cast<VTexture&>(dstTex);
 
@@ -665,7 +670,7 @@ void VCommandBuffer::copy(AbstractGraphicsApi::Texture& dstTex, size_t width, si
   region.imageSubresource.mipLevel = uint32_t(mip);
   region.imageSubresource.baseArrayLayer = 0;
   region.imageSubresource.layerCount = 1;
-  region.imageOffset = {0, 0, 0};
+  region.imageOffset = {int32_t(x), int32_t(y), 0};
   region.imageExtent = {
       uint32_t(width),
       uint32_t(height),
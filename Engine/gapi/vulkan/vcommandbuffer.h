@@ -82,6 +82,8 @@ class VCommandBuffer:public AbstractGraphicsApi::CommandBuffer {
     void generateMipmap(AbstractGraphicsApi::Texture& image, uint32_t texWidth, uint32_t texHeight, uint32_t mipLevels) override;
 
     void copy(AbstractGraphicsApi::Texture& dest, size_t width, size_t height, size_t mip, const AbstractGraphicsApi::Buffer&  src, size_t offset);
+    void copy(AbstractGraphicsApi::Texture& dest, size_t x, size_t y, size_t width, size_t height, size_t mip,
+              const AbstractGraphicsApi::Buffer& src, size_t offset);
     void copy(AbstractGraphicsApi::Buffer&  dest, size_t offsetDest, const AbstractGraphicsApi::Buffer& src, size_t offsetSrc, size_t size);
     void copy(AbstractGraphicsApi::Buffer&  dest, size_t offsetDest, const void* src, size_t size);
     void fill(AbstractGraphicsApi::Texture& dest, uint32_t val);
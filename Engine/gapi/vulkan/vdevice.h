@@ -344,7 +344,6 @@ class VDevice : public AbstractGraphicsApi::Device {
     Queue*                  graphicsQueue = nullptr;
     Queue*                  presentQueue  = nullptr;
 
-    std::mutex              allocSync;
     VAllocator              allocator;
 
     VFramebufferMap         fboMap;
@@ -276,6 +276,29 @@ void VulkanApi::readBytes(AbstractGraphicsApi::Device*, AbstractGraphicsApi::Buf
   bx.read(out,0,size);
   }
 
+void VulkanApi::updateTexture(AbstractGraphicsApi::Device* d, PTexture t, const void* data, TextureFormat frm,
+                              uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+  Detail::VDevice& dx    = *reinterpret_cast<Detail::VDevice*>(d);
+  const size_t     size  = size_t(w)*size_t(h)*Pixmap::bppForFormat(frm);
+
+  Detail::VBuffer  stage = dx.dataMgr().allocStagingMemory(data,size,MemUsage::TransferSrc,BufferHeap::Upload);
+  Detail::DSharedPtr<Buffer*>  pstage(new Detail::VBuffer(std::move(stage)));
+  Detail::DSharedPtr<Texture*> pbuf  (t.handler);
+
+  auto cmd = dx.dataMgr().get();
+  cmd->begin();
+  cmd->hold(pstage);
+  cmd->hold(pbuf); // NOTE: texture may be deleted, before copy is finished
+  // same queue as rendering: barrier waits for previously submitted reads of this texture
+  cmd->barrier(*pbuf.handler, ResourceAccess::Sampler, ResourceAccess::TransferDst, uint32_t(-1));
+  cmd->copy(*pbuf.handler,x,y,w,h,0,*pstage.handler,0);
+  cmd->barrier(*pbuf.handler, ResourceAccess::TransferDst, ResourceAccess::Sampler, uint32_t(-1));
+  cmd->end();
+
+  dx.dataMgr().waitFor(pbuf.handler); // write-after-write case
+  dx.dataMgr().submit(std::move(cmd));
+  }
+
 AbstractGraphicsApi::Desc* VulkanApi::createDescriptors(AbstractGraphicsApi::Device* d, PipelineLay& ulayImpl) {
   auto& dx = *reinterpret_cast<Detail::VDevice*>(d);
   auto& ul = reinterpret_cast<Detail::VPipelineLay&>(ulayImpl);
@@ -13,6 +13,14 @@ Builtin::Builtin(Device& device)
   if(internalShaders) {
     brushE  = mkShaderSet(false);
     brushT2 = mkShaderSet(true);
+
+    auto vs = device.shader(tex_brush_vert_sprv,sizeof(tex_brush_vert_sprv));
+    auto fs = device.shader(df_brush_frag_sprv, sizeof(df_brush_frag_sprv));
+    brushDf = mkShaderSet(vs,fs);
+
+    vs   = device.shader(polyline_vert_sprv,sizeof(polyline_vert_sprv));
+    fs   = device.shader(polyline_frag_sprv,sizeof(polyline_frag_sprv));
+    line = mkShaderSet(vs,fs,false);
     }
   }
 
@@ -25,7 +33,10 @@ Builtin::Item Builtin::mkShaderSet(bool textures) {
     vs = device.shader(empty_vert_sprv,    sizeof(empty_vert_sprv));
     fs = device.shader(empty_frag_sprv,    sizeof(empty_frag_sprv));
     }
+  return mkShaderSet(vs,fs);
+  }
 
+Builtin::Item Builtin::mkShaderSet(const Shader& vs, const Shader& fs, bool pen) {
   RenderState stNormal, stBlend, stAlpha;
   stNormal.setZWriteEnabled(false);
 
@@ -38,13 +49,14 @@ Builtin::Item Builtin::mkShaderSet(bool textures) {
   stAlpha.setZWriteEnabled(false);
 
   Item ret;
-  ret.pen    = device.pipeline(Lines,    stNormal,vs,fs);
   ret.brush  = device.pipeline(Triangles,stNormal,vs,fs);
-
-  ret.penB   = device.pipeline(Lines,    stBlend,vs,fs);
   ret.brushB = device.pipeline(Triangles,stBlend,vs,fs);
+  ret.brushA = device.pipeline(Triangles,stAlpha,vs,fs);
+  if(!pen)
+    return ret;
 
+  ret.pen    = device.pipeline(Lines,    stNormal,vs,fs);
+  ret.penB   = device.pipeline(Lines,    stBlend,vs,fs);
   ret.penA   = device.pipeline(Lines,    stAlpha,vs,fs);
-  ret.brushA = device.pipeline(Triangles,stAlpha,vs,fs);
   return ret;
   }
@@ -26,15 +26,21 @@ class Builtin final {
       Tempest::RenderPipeline brushA;
       };
 
-    const Item& texture2d() const { return brushT2; }
-    const Item& empty    () const { return brushE;  }
+    const Item& texture2d    () const { return brushT2; }
+    const Item& empty        () const { return brushE;  }
+    const Item& distanceField() const { return brushDf; }
+    // triangle pipelines only, geometry is expanded from storage buffer in vertex shader
+    const Item& polyline     () const { return line;    }
 
   private:
     Item            mkShaderSet(bool textures);
+    Item            mkShaderSet(const Shader& vs, const Shader& fs, bool pen = true);
 
     Device&         device;
     Item            brushT2;
     Item            brushE;
+    Item            brushDf;
+    Item            line;
 
   friend class Device;
   };
@@ -5,16 +5,25 @@
 #include <Tempest/Encoder>
 #include <Tempest/Except>
 
+#include "transientstorage.h"
+
 using namespace Tempest;
 
+CommandBuffer::CommandBuffer() {
+  }
+
 CommandBuffer::CommandBuffer(Device& dev, AbstractGraphicsApi::CommandBuffer* impl)
   :dev(&dev),impl(impl) {
   }
 
+CommandBuffer::CommandBuffer(CommandBuffer&& f) = default;
+
 CommandBuffer::~CommandBuffer() {
   delete impl.handler;
   }
 
+CommandBuffer& CommandBuffer::operator = (CommandBuffer&& other) = default;
+
 Encoder<CommandBuffer> CommandBuffer::startEncoding(Device& device) {
   if(impl.handler!=nullptr && impl.handler->isRecording())
     throw ConcurentRecordingException();
@@ -22,5 +31,8 @@ Encoder<CommandBuffer> CommandBuffer::startEncoding(Device& device) {
     *this  = device.commandBuffer();
     dev    = &device;
     }
+  if(transient==nullptr)
+    transient.reset(new Detail::TransientStorage()); else
+    transient->reset();
   return Encoder<CommandBuffer>(this);
   }
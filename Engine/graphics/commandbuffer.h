@@ -4,6 +4,8 @@
 #include <Tempest/Encoder>
 #include "../utility/dptr.h"
 
+#include <memory>
+
 namespace Tempest {
 
 class Device;
@@ -12,6 +14,10 @@ class RenderPipeline;
 class DescriptorSet;
 class Texture2d;
 
+namespace Detail {
+class TransientStorage;
+}
+
 template<class T>
 class Encoder;
 
@@ -20,10 +26,10 @@ class CommandBuffer;
 
 class CommandBuffer final {
   public:
-    CommandBuffer()=default;
-    CommandBuffer(CommandBuffer&& f)=default;
+    CommandBuffer();
+    CommandBuffer(CommandBuffer&& f);
     ~CommandBuffer();
-    CommandBuffer& operator = (CommandBuffer&& other)=default;
+    CommandBuffer& operator = (CommandBuffer&& other);
 
     auto startEncoding(Tempest::Device& dev) -> Encoder<CommandBuffer>;
 
@@ -32,6 +38,7 @@ class CommandBuffer final {
 
     Tempest::Device*                                    dev=nullptr;
     Detail::DPtr<AbstractGraphicsApi::CommandBuffer*>   impl;
+    std::unique_ptr<Detail::TransientStorage>           transient;
 
   friend class Tempest::Device;
   friend class Tempest::Encoder<CommandBuffer>;
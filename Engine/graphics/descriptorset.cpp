@@ -108,6 +108,12 @@ void DescriptorSet::set(size_t layoutBind, const StorageBuffer& vbuf, size_t off
   implBindSsbo(layoutBind,vbuf.impl,offset);
   }
 
+void DescriptorSet::set(size_t layoutBind, const TransientBuffer& vbuf) {
+  if(vbuf.impl.handler==nullptr)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidUniformBuffer);
+  impl.handler->set(layoutBind,vbuf.impl.handler,vbuf.off);
+  }
+
 void DescriptorSet::implBindUbo(size_t layoutBind, const Detail::VideoBuffer& vbuf) {
   if(vbuf.impl.handler)
     impl.handler->set(layoutBind,vbuf.impl.handler,0); else
@@ -2,6 +2,7 @@
 
 #include <Tempest/AbstractGraphicsApi>
 #include <Tempest/UniformBuffer>
+#include <Tempest/TransientBuffer>
 #include <Tempest/Except>
 
 namespace Tempest {
@@ -30,6 +31,8 @@ class DescriptorSet final {
 
     void set(size_t layoutBind, const StorageBuffer& vbuf);
     void set(size_t layoutBind, const StorageBuffer& vbuf, size_t offset);
+    // bind into a set that is not in use yet, e.g. one from Encoder::descriptors
+    void set(size_t layoutBind, const TransientBuffer& vbuf);
 
     void set(size_t layoutBind, const Texture2d&    tex, const Sampler& smp = Sampler::anisotrophy());
     void set(size_t layoutBind, const Attachment&   tex, const Sampler& smp = Sampler::anisotrophy());
@@ -9,6 +9,7 @@
 #include <Tempest/Except>
 
 #include <string>
+#include <cstring>
 #include <cassert>
 
 using namespace Tempest;
@@ -262,6 +263,26 @@ AccelerationStructure Device::tlas(const RtInstance* geom, size_t geomSize) {
   return AccelerationStructure(*this,tlas);
   }
 
+void Device::update(Texture2d& t, const Pixmap& pm, const Rect& r) {
+  if(t.isEmpty() || t.format()!=pm.format() || t.w()!=int(pm.w()) || t.h()!=int(pm.h()) || t.mipCount()!=1)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidTexture);
+  if(isCompressedFormat(pm.format()))
+    throw std::system_error(Tempest::GraphicsErrc::UnsupportedTextureFormat);
+
+  const Rect rc = r.intersected(Rect(0,0,t.w(),t.h()));
+  if(rc.isEmpty())
+    return;
+
+  const size_t         bpp = Pixmap::bppForFormat(pm.format());
+  const size_t         row = size_t(rc.w)*bpp;
+  auto                 src = reinterpret_cast<const uint8_t*>(pm.data());
+  std::vector<uint8_t> px(row*size_t(rc.h));
+  for(int y=0; y<rc.h; ++y)
+    std::memcpy(&px[size_t(y)*row], src+(size_t(rc.y+y)*pm.w()+size_t(rc.x))*bpp, row);
+
+  api.updateTexture(dev,t.impl,px.data(),pm.format(),uint32_t(rc.x),uint32_t(rc.y),uint32_t(rc.w),uint32_t(rc.h));
+  }
+
 Pixmap Device::readPixels(const Texture2d &t, uint32_t mip) {
   Pixmap pm;
   api.readPixels(dev,pm,t.impl,t.format(),uint32_t(t.w()),uint32_t(t.h()),mip,false);
@@ -38,6 +38,10 @@ class PipelineLayout;
 class Color;
 class RenderState;
 
+namespace Detail {
+class TransientStorage;
+}
+
 class Device {
   public:
     using Props=AbstractGraphicsApi::Props;
@@ -124,6 +128,9 @@ class Device {
     DescriptorSet         descriptors(const PipelineLayout&  lay);
 
     Texture2d             texture    (const Pixmap& pm, const bool mips = true);
+    // copies rect r of pm to same place in t, created from a pixmap of same size and format, without mips;
+    // doesn't wait for device, copy is ordered after previously submitted work
+    void                  update     (Texture2d& t, const Pixmap& pm, const Rect& r);
     Attachment            attachment (TextureFormat frm, const uint32_t w, const uint32_t h, const bool mips = false);
     ZBuffer               zbuffer    (TextureFormat frm, const uint32_t w, const uint32_t h);
     StorageImage          image2d    (TextureFormat frm, const uint32_t w, const uint32_t h, const bool mips = false);
@@ -190,6 +197,7 @@ class Device {
   friend class DescriptorSet;
 
   friend class Texture2d;
+  friend class Detail::TransientStorage;
   };
 
 template<class T>
@@ -4,9 +4,11 @@
 #include <Tempest/ZBuffer>
 #include <Tempest/Texture2d>
 #include <Tempest/StorageBuffer>
+#include <Tempest/Device>
 #include <cassert>
 
 #include "utility/compiller_hints.h"
+#include "transientstorage.h"
 
 using namespace Tempest;
 
@@ -21,20 +23,22 @@ static uint32_t mipCount(uint32_t w, uint32_t h) {
   }
 
 Encoder<Tempest::CommandBuffer>::Encoder(Tempest::CommandBuffer* ow)
-  :impl(ow->impl.handler) {
+  :impl(ow->impl.handler), dev(ow->dev), transient(ow->transient.get()) {
   impl->begin();
   }
 
 Encoder<CommandBuffer>::Encoder(Encoder<CommandBuffer> &&e)
-  :impl(e.impl),state(std::move(e.state)) {
+  :impl(e.impl),dev(e.dev),transient(e.transient),state(std::move(e.state)) {
   e.impl  = nullptr;
   }
 
 Encoder<CommandBuffer> &Encoder<CommandBuffer>::operator =(Encoder<CommandBuffer> &&e) {
-  impl   = e.impl;
-  state  = std::move(e.state);
+  impl      = e.impl;
+  dev       = e.dev;
+  transient = e.transient;
+  state     = std::move(e.state);
 
-  e.impl = nullptr;
+  e.impl    = nullptr;
   return *this;
   }
 
@@ -46,6 +50,18 @@ Encoder<Tempest::CommandBuffer>::~Encoder() noexcept(false) {
   impl->end();
   }
 
+TransientBuffer Encoder<Tempest::CommandBuffer>::upload(const void* data, size_t size) {
+  return transient->alloc(*dev,data,size);
+  }
+
+DescriptorSet& Encoder<Tempest::CommandBuffer>::descriptors(const RenderPipeline& p) {
+  return transient->descriptors(*dev,p.layout());
+  }
+
+DescriptorSet& Encoder<Tempest::CommandBuffer>::descriptors(const ComputePipeline& p) {
+  return transient->descriptors(*dev,p.layout());
+  }
+
 void Encoder<Tempest::CommandBuffer>::setViewport(int x, int y, int w, int h) {
   impl->setViewport(Rect(x,y,w,h));
   }
@@ -55,11 +71,12 @@ void Encoder<Tempest::CommandBuffer>::setViewport(const Rect &vp) {
   }
 
 void Encoder<Tempest::CommandBuffer>::setScissor(int x,int y,int w,int h) {
-  impl->setScissor(Rect(x,y,w,h));
+  setScissor(Rect(x,y,w,h));
   }
 
 void Encoder<Tempest::CommandBuffer>::setScissor(const Rect &vp) {
   impl->setScissor(vp);
+  state.scissor = vp;
   }
 
 void Encoder<Tempest::CommandBuffer>::setDebugMarker(std::string_view tag) {
@@ -275,6 +292,7 @@ void Tempest::Encoder<Tempest::CommandBuffer>::implSetFramebuffer(const Attachme
                        frm,att,sw,imgId);
   state.stage      = Rendering;
   state.curPipeline = nullptr;
+  state.scissor     = Rect(0,0,int(w),int(h));
   }
 
 void Encoder<CommandBuffer>::copy(const Attachment& src, uint32_t mip, StorageBuffer& dest, size_t offset) {
@@ -4,6 +4,9 @@
 #include <Tempest/RenderPipeline>
 #include <Tempest/ComputePipeline>
 #include <Tempest/DescriptorSet>
+#include <Tempest/TransientBuffer>
+
+#include <type_traits>
 
 namespace Tempest {
 
@@ -14,6 +17,11 @@ template<class T>
 class IndexBuffer;
 
 class CommandBuffer;
+class Device;
+
+namespace Detail {
+class TransientStorage;
+}
 
 template<class T>
 class Encoder;
@@ -38,11 +46,25 @@ class Encoder<Tempest::CommandBuffer> {
     void setUniforms(const ComputePipeline& p, const DescriptorSet &ubo);
     void setUniforms(const ComputePipeline& p);
 
+    // per-draw data, valid until this command buffer is recorded again; bind it into a set from descriptors()
+    template<class T>
+    TransientBuffer upload(const T& data) {
+      static_assert(std::is_trivially_copyable<T>::value, "upload requires POD data");
+      return upload(&data,sizeof(T));
+      }
+    TransientBuffer upload(const void* data, size_t size);
+
+    // set owned by this command buffer, new for each call, recycled when recorded again; its bindings are stale, set all of them
+    DescriptorSet&  descriptors(const RenderPipeline&  p);
+    DescriptorSet&  descriptors(const ComputePipeline& p);
+
     void setViewport(int x,int y,int w,int h);
     void setViewport(const Rect& vp);
 
     void setScissor(int x,int y,int w,int h);
     void setScissor(const Rect& vp);
+    // current scissor; reset to whole framebuffer by setFramebuffer
+    const Rect& scissor() const { return state.scissor; }
 
     void setDebugMarker(std::string_view tag);
 
@@ -116,9 +138,12 @@ class Encoder<Tempest::CommandBuffer> {
       const AbstractGraphicsApi::Pipeline*     curPipeline = nullptr;
       const AbstractGraphicsApi::CompPipeline* curCompute  = nullptr;
       Stage                                    stage       = None;
+      Rect                                     scissor;
       };
 
     AbstractGraphicsApi::CommandBuffer* impl = nullptr;
+    Device*                             dev  = nullptr;
+    Detail::TransientStorage*           transient = nullptr;
     State                               state;
 
     void         implSetFramebuffer(const AttachmentDesc* rt, size_t rtSize, const AttachmentDesc* zs);
@@ -6,6 +6,10 @@ namespace Tempest {
 
 class Device;
 
+namespace Detail {
+class TransientStorage;
+}
+
 class PipelineLayout final {
   public:
     PipelineLayout(PipelineLayout&& other)=default;
@@ -19,6 +23,7 @@ class PipelineLayout final {
     Detail::DSharedPtr<AbstractGraphicsApi::PipelineLay*> impl;
 
   friend class Device;
+  friend class Detail::TransientStorage;
   friend class RenderPipeline;
   friend class ComputePipeline;
   };
@@ -2,6 +2,8 @@
 
 #include <Tempest/Device>
 
+#include <utility>
+
 using namespace Tempest;
 
 Sprite::Sprite() {
@@ -17,15 +19,28 @@ const Texture2d& Sprite::pageRawData(Device& dev) const {
     return t;
     }
 
-  auto& mem=alloc.memory();
-  if( mem.changed ){
-    dev.waitIdle(); //FIXME: track usage of mem.gpu
-    mem.gpu=dev.texture(mem.cpu,false);
-    mem.changed=false;
+  // atlas may place sprites into this page from other threads: take dirty area and read pixels under its lock
+  auto  guard = alloc.lock();
+  auto& mem   = alloc.memory();
+  const Rect dirty = std::exchange(mem.dirty,Rect());
+  if(mem.gpu.isEmpty()) {
+    mem.gpu = dev.texture(mem.cpu,false);
+    }
+  else if(!dirty.isEmpty()) {
+    // only newly placed sprites; existing texture keeps being valid for frames in flight
+    dev.update(mem.gpu,mem.cpu,dirty);
     }
   return mem.gpu;
   }
 
+const Pixmap& Sprite::pagePixmap() const {
+  if(!alloc.owner){
+    static const Pixmap p;
+    return p;
+    }
+  return alloc.memory().cpu;
+  }
+
 const Rect Sprite::pageRect() const {
   if(alloc.owner){
     return alloc.pageRect();
@@ -16,6 +16,7 @@ class Sprite final {
     Size size() const { return Size(int(texW),int(texH)); }
 
     const Tempest::Texture2d& pageRawData(Device &dev) const;
+    const Tempest::Pixmap&    pagePixmap() const;
     const Rect                pageRect() const;
 
     void*                     pageId() const;
@@ -1,15 +1,21 @@
 #include "textureatlas.h"
 
 #include <Tempest/Sprite>
+#include <Tempest/Device>
 #include <Tempest/Log>
 #include <cstring>
+#include <algorithm>
 
 #include "thirdparty/squish/squish.h"
 
 using namespace Tempest;
 
 TextureAtlas::TextureAtlas(Device& device)
-  :device(device),alloc(provider) {
+  :device(&device),alloc(provider,PageAllocator::MaxRects),allocR8(providerR8,PageAllocator::Skyline) {
+  }
+
+TextureAtlas::TextureAtlas()
+  :alloc(provider,PageAllocator::MaxRects),allocR8(providerR8,PageAllocator::Skyline) {
   }
 
 TextureAtlas::~TextureAtlas() {
@@ -20,19 +26,61 @@ Sprite TextureAtlas::load(const Pixmap &pm) {
   }
 
 Sprite TextureAtlas::load(const void *data, uint32_t w, uint32_t h, TextureFormat format) {
-  auto a = alloc.alloc(w,h);
-  auto p = a.pos();
-  emplace(a,data,w,h,format,uint32_t(p.x),uint32_t(p.y));
+  // pixels are written under allocator lock: compact() may not move sprite before it's filled
+  auto a = (format==TextureFormat::R8 ? allocR8 : alloc).alloc(w,h,[&](Memory& m, const Point& p){
+    emplace(m,data,w,h,format,uint32_t(p.x),uint32_t(p.y));
+    });
   Sprite ret(std::move(a),w,h);
   return ret;
   }
 
-void TextureAtlas::emplace(TextureAtlas::Allocation &dest, const void* img,
+void TextureAtlas::setPageSize(uint32_t size) {
+  if(device!=nullptr)
+    size = std::min(size,device->properties().tex2d.maxSize);
+  alloc  .setPageSize(size);
+  allocR8.setPageSize(size);
+  }
+
+size_t TextureAtlas::compact() {
+  // cpu copy is the source of truth: moved sprites are uploaded as dirty rect of destination page
+  auto move = [](const Memory& src, const Rect& r, Memory& dst, uint32_t x, uint32_t y) {
+    const size_t bpp = src.cpu.format()==TextureFormat::R8 ? 1 : 4;
+    auto         s   = reinterpret_cast<const uint8_t*>(src.cpu.data());
+    auto         d   = reinterpret_cast<uint8_t*>(dst.cpu.data());
+    for(int i=0; i<r.h; ++i)
+      std::memcpy(d+((y+uint32_t(i))*dst.cpu.w()+x)*bpp, s+(uint32_t(r.y+i)*src.cpu.w()+uint32_t(r.x))*bpp, size_t(r.w)*bpp);
+    markDirty(dst,Rect(int(x),int(y),r.w,r.h));
+    };
+  return alloc.compact(move) + allocR8.compact(move);
+  }
+
+void TextureAtlas::markDirty(Memory& m, const Rect& r) {
+  if(m.dirty.isEmpty()) {
+    m.dirty = r;
+    return;
+    }
+  const int x0 = std::min(m.dirty.x,r.x);
+  const int y0 = std::min(m.dirty.y,r.y);
+  const int x1 = std::max(m.dirty.x+m.dirty.w,r.x+r.w);
+  const int y1 = std::max(m.dirty.y+m.dirty.h,r.y+r.h);
+  m.dirty = Rect(x0,y0,x1-x0,y1-y0);
+  }
+
+void TextureAtlas::emplace(Memory& dest, const void* img,
                            uint32_t pw, uint32_t ph, TextureFormat format,
                            uint32_t x, uint32_t y) {
-  dest.memory().changed=true;
-  Pixmap&  cpu  = dest.memory().cpu;
+  markDirty(dest,Rect(int(x),int(y),int(pw),int(ph)));
+  Pixmap&  cpu  = dest.cpu;
   auto     data = reinterpret_cast<uint8_t*>(cpu.data());
+
+  if(cpu.format()==TextureFormat::R8) {
+    // only R8 images are placed to R8 pages
+    auto src = reinterpret_cast<const uint8_t*>(img);
+    for(uint32_t iy=0;iy<ph;++iy)
+      std::memcpy(data+((y+iy)*cpu.w()+x),src+iy*pw,pw);
+    return;
+    }
+
   uint32_t dx   = x*4;
   uint32_t dw   = cpu.w()*4;
 
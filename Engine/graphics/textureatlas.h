@@ -17,30 +17,47 @@ class Sprite;
 class TextureAtlas {
   public:
     TextureAtlas(Device& device);
+    // cpu-only atlas, for software painting (RasterImage): pages are never uploaded and page size is not clamped
+    TextureAtlas();
     TextureAtlas(const TextureAtlas&)=delete;
     virtual ~TextureAtlas();
 
     Sprite load(const Pixmap& pm);
     Sprite load(const void* data, uint32_t w, uint32_t h, TextureFormat format);
 
+    // Size of new pages, clamped to device limits. Every page is a texture of its own and painting breaks batches
+    // on page change, so bigger pages mean fewer descriptor switches, at cost of memory.
+    // Existing smaller pages are merged into one by compact().
+    void     setPageSize(uint32_t size);
+    uint32_t pageSize() const { return alloc.pageSize(); }
+
+    // Repacks sprites of sparse pages into denser ones and releases empty pages; returns by how many pages the atlas shrunk.
+    // Only sprites with a single owner are moved (sprites recorded into painted images stay in place), so owners see
+    // the new placement transparently. Can run on background thread along with load(), but not while sprites are painted:
+    // load() fills new sprite under the same lock, so a sprite is never moved half-written.
+    size_t compact();
+
   private:
     struct Memory {
       Memory()=default;
-      Memory(uint32_t w,uint32_t h):cpu(w,h,TextureFormat::RGBA8){}
+      Memory(uint32_t w,uint32_t h,TextureFormat frm):cpu(w,h,frm){}
       Memory(Memory&&)=default;
 
       Memory& operator=(Memory&&)=default;
 
       Pixmap            cpu;
       mutable Texture2d gpu;
-      mutable bool      changed=true;
+      // area of cpu, that is not uploaded to gpu yet; guarded by allocator lock, as well as cpu pixels
+      mutable Rect      dirty;
       };
 
     struct MemoryProvider {
       using DeviceMemory=Memory;
 
+      explicit MemoryProvider(TextureFormat frm):format(frm){}
+
       DeviceMemory alloc(uint32_t w,uint32_t h){
-        DeviceMemory ret(w,h);
+        DeviceMemory ret(w,h,format);
         return ret;
         }
 
@@ -48,17 +65,24 @@ class TextureAtlas {
         // nop
         m=DeviceMemory();
         }
+
+      const TextureFormat format;
       };
 
-    using Allocation = typename Tempest::RectAllocator<MemoryProvider>::Allocation;
+    using PageAllocator = Tempest::RectAllocator<MemoryProvider>;
+    using Allocation    = typename PageAllocator::Allocation;
 
-    void emplace(Allocation& dest, const void *img,
+    void emplace(Memory& dest, const void *img,
                  uint32_t w, uint32_t h, TextureFormat frm,
                  uint32_t x, uint32_t y);
-
-    Device&                                 device;
-    MemoryProvider                          provider;
-    Tempest::RectAllocator<MemoryProvider> alloc;
+    static void markDirty(Memory& m, const Rect& r);
+
+    Device*                                 device = nullptr;
+    MemoryProvider                          provider{TextureFormat::RGBA8};
+    PageAllocator                           alloc;
+    // single channel pages for coverage masks (glyphs), 4x smaller than RGBA8
+    MemoryProvider                          providerR8{TextureFormat::R8};
+    PageAllocator                           allocR8;
 
   friend class Sprite;
   };
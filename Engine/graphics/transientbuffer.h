@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Tempest/AbstractGraphicsApi>
+#include "../utility/dptr.h"
+
+namespace Tempest {
+
+class DescriptorSet;
+
+namespace Detail {
+class TransientStorage;
+}
+
+// Range of upload memory owned by a command buffer, made by Encoder::upload.
+// Content is valid until the command buffer is recorded again or destroyed; bind it with DescriptorSet::set.
+class TransientBuffer final {
+  public:
+    TransientBuffer()=default;
+
+    bool   isEmpty()  const { return sz==0;  }
+    size_t byteSize() const { return sz;     }
+    size_t offset()   const { return off;    }
+
+  private:
+    TransientBuffer(const Detail::DSharedPtr<AbstractGraphicsApi::Buffer*>& buf, size_t off, size_t sz)
+      :impl(buf),off(off),sz(sz) {
+      }
+
+    Detail::DSharedPtr<AbstractGraphicsApi::Buffer*> impl;
+    size_t                                           off = 0;
+    size_t                                           sz  = 0;
+
+  friend class Tempest::Detail::TransientStorage;
+  friend class Tempest::DescriptorSet;
+  };
+
+}
@@ -0,0 +1,65 @@
+#include "transientstorage.h"
+
+#include <Tempest/Device>
+#include <Tempest/PipelineLayout>
+
+#include <algorithm>
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+void TransientStorage::reset() {
+  for(auto& i:blocks)
+    i.used = 0;
+  for(auto& i:pools)
+    i.used = 0;
+  current = 0;
+  }
+
+TransientBuffer TransientStorage::alloc(Device& dev, const void* data, size_t size) {
+  static const auto usageBits = MemUsage::VertexBuffer  | MemUsage::IndexBuffer   |
+                                MemUsage::UniformBuffer | MemUsage::StorageBuffer |
+                                MemUsage::TransferSrc;
+  if(size==0)
+    return TransientBuffer();
+
+  auto&        prop  = dev.properties();
+  const size_t align = std::max<size_t>(1, std::max(prop.ubo.offsetAlign,prop.ssbo.offsetAlign));
+
+  for(; current<blocks.size(); ++current) {
+    auto&  b  = blocks[current];
+    size_t at = ((b.used+align-1)/align)*align;
+    if(at+size>b.buf.size())
+      continue;
+    b.used = at+size;
+    b.buf.update(data,at,size);
+    return TransientBuffer(b.buf.impl,at,size);
+    }
+
+  // blocks are kept for next recordings: memory is bounded by the largest recording
+  Block b;
+  b.buf  = dev.createVideoBuffer(nullptr,std::max<size_t>(BlockSize,size),usageBits,BufferHeap::Upload);
+  b.used = size;
+  b.buf.update(data,0,size);
+  blocks.emplace_back(std::move(b));
+  current = blocks.size()-1;
+  return TransientBuffer(blocks[current].buf.impl,0,size);
+  }
+
+DescriptorSet& TransientStorage::descriptors(Device& dev, const PipelineLayout& lay) {
+  // set holds a reference to layout, so the key can't be reused while pool is alive
+  Pool* pool = nullptr;
+  for(auto& i:pools)
+    if(i.lay==lay.impl.handler) {
+      pool = &i;
+      break;
+      }
+  if(pool==nullptr) {
+    pools.emplace_back();
+    pool      = &pools.back();
+    pool->lay = lay.impl.handler;
+    }
+  if(pool->used==pool->sets.size())
+    pool->sets.emplace_back(dev.descriptors(lay));
+  return pool->sets[pool->used++];
+  }
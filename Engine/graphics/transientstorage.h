@@ -0,0 +1,52 @@
+#pragma once
+
+#include <Tempest/DescriptorSet>
+#include <Tempest/TransientBuffer>
+
+#include "videobuffer.h"
+
+#include <deque>
+#include <vector>
+
+namespace Tempest {
+
+class Device;
+class PipelineLayout;
+
+namespace Detail {
+
+// Upload memory and descriptor sets of one command buffer, for Encoder::upload and Encoder::descriptors.
+// Nothing is released per frame: everything is reused, when command buffer is recorded again,
+// since by then its previous submit must be complete.
+class TransientStorage {
+  public:
+    TransientStorage() = default;
+
+    void            reset();
+
+    TransientBuffer alloc(Device& dev, const void* data, size_t size);
+    DescriptorSet&  descriptors(Device& dev, const PipelineLayout& lay);
+
+  private:
+    enum : size_t {
+      BlockSize = 256*1024,
+      };
+
+    struct Block {
+      VideoBuffer buf;
+      size_t      used = 0;
+      };
+
+    struct Pool {
+      const AbstractGraphicsApi::PipelineLay* lay  = nullptr;
+      std::deque<DescriptorSet>               sets;
+      size_t                                  used = 0;
+      };
+
+    std::vector<Block> blocks;
+    size_t             current = 0;
+    std::deque<Pool>   pools;
+  };
+
+}
+}
@@ -13,6 +13,8 @@ class Encoder;
 
 namespace Detail {
 
+class TransientStorage;
+
 class VideoBuffer {
   public:
     VideoBuffer()=default;
@@ -33,6 +35,7 @@ class VideoBuffer {
   friend class Tempest::CommandBuffer;
   friend class Tempest::DescriptorSet;
   friend class Tempest::Encoder<Tempest::CommandBuffer>;
+  friend class TransientStorage;
   };
 
 }
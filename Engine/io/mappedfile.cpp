@@ -0,0 +1,114 @@
+#include "mappedfile.h"
+
+#include <Tempest/TextCodec>
+#include <Tempest/Except>
+#include <Tempest/Platform>
+
+#if defined(__WINDOWS__)
+#include <windows.h>
+#elif !defined(__IOS__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <string>
+#include <system_error>
+#include <utility>
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+MappedFile::MappedFile(const char* path) {
+#ifdef __WINDOWS__
+  std::wstring wpath;
+  const int len = MultiByteToWideChar(CP_UTF8,0,path,-1,nullptr,0);
+  if(len>1){
+    wpath.resize(size_t(len-1));
+    MultiByteToWideChar(CP_UTF8,0,path,-1,&wpath[0],int(wpath.size()));
+    }
+  implOpen(wpath.c_str());
+#else
+  implOpen(path);
+#endif
+  }
+
+MappedFile::MappedFile(const char16_t* path) {
+#ifdef __WINDOWS__
+  implOpen(reinterpret_cast<const wchar_t*>(path));
+#else
+  implOpen(TextCodec::toUtf8(path).c_str());
+#endif
+  }
+
+MappedFile::MappedFile(MappedFile&& other)
+  :ptr(other.ptr), sz(other.sz), mapping(other.mapping) {
+  other.ptr     = nullptr;
+  other.sz      = 0;
+  other.mapping = nullptr;
+  }
+
+MappedFile::~MappedFile() {
+  if(ptr==nullptr)
+    return;
+#if defined(__WINDOWS__)
+  UnmapViewOfFile(ptr);
+  CloseHandle(HANDLE(mapping));
+#elif !defined(__IOS__)
+  munmap(const_cast<uint8_t*>(ptr),sz);
+#endif
+  }
+
+MappedFile& MappedFile::operator =(MappedFile&& other) {
+  std::swap(ptr,    other.ptr);
+  std::swap(sz,     other.sz);
+  std::swap(mapping,other.mapping);
+  return *this;
+  }
+
+#if defined(__WINDOWS__)
+void MappedFile::implOpen(const wchar_t* path) {
+  HANDLE fn = CreateFileW(path,GENERIC_READ,FILE_SHARE_READ,nullptr,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,nullptr);
+  if(fn==HANDLE(LONG_PTR(-1)))
+    throw std::system_error(Tempest::SystemErrc::UnableToOpenFile);
+
+  LARGE_INTEGER len = {};
+  if(GetFileSizeEx(fn,&len) && len.QuadPart>0) {
+    // mapping keeps reference to the file
+    HANDLE m = CreateFileMappingW(fn,nullptr,PAGE_READONLY,0,0,nullptr);
+    if(m!=nullptr) {
+      void* view = MapViewOfFile(m,FILE_MAP_READ,0,0,0);
+      if(view!=nullptr) {
+        ptr     = reinterpret_cast<const uint8_t*>(view);
+        sz      = size_t(len.QuadPart);
+        mapping = m;
+        } else {
+        CloseHandle(m);
+        }
+      }
+    }
+  CloseHandle(fn);
+  }
+#elif defined(__IOS__)
+void MappedFile::implOpen(const char*) {
+  // relative paths are resolved against application bundle by RFile
+  }
+#else
+void MappedFile::implOpen(const char* path) {
+  int fd = open(path,O_RDONLY);
+  if(fd<0)
+    throw std::system_error(Tempest::SystemErrc::UnableToOpenFile);
+
+  struct stat st = {};
+  if(fstat(fd,&st)==0 && st.st_size>0) {
+    void* view = mmap(nullptr,size_t(st.st_size),PROT_READ,MAP_PRIVATE,fd,0);
+    if(view!=MAP_FAILED) {
+      ptr = reinterpret_cast<const uint8_t*>(view);
+      sz  = size_t(st.st_size);
+      }
+    }
+  // mapping stays valid after close
+  close(fd);
+  }
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Tempest {
+namespace Detail {
+
+// Read-only mapping of whole file into memory.
+// data() is nullptr, if platform can't map this file - caller should fallback to RFile.
+class MappedFile final {
+  public:
+    MappedFile()=default;
+    explicit MappedFile(const char*     path);
+    explicit MappedFile(const char16_t* path);
+    MappedFile(MappedFile&& other);
+    ~MappedFile();
+
+    MappedFile& operator = (MappedFile&& other);
+
+    const uint8_t* data() const { return ptr; }
+    size_t         size() const { return sz;  }
+
+  private:
+    const uint8_t* ptr     = nullptr;
+    size_t         sz      = 0;
+    void*          mapping = nullptr;
+
+#ifdef __WINDOWS__
+    void implOpen(const wchar_t* path);
+#else
+    void implOpen(const char* path);
+#endif
+  };
+
+}
+}
@@ -16,7 +16,12 @@ layout(location = 0) out vec4 outColor;
 layout(location = 0) in  vec4 inColor;
 
 void main() {
-#if defined(TEXTURE)
+#if defined(DISTANCE_FIELD)
+  // glyph distance is stored in alpha, edge at 0.5
+  float d  = texture(texSampler,inUV).a;
+  float aa = max(fwidth(d),1.0/255.0)*0.75;
+  outColor = vec4(inColor.rgb, inColor.a*smoothstep(0.5-aa,0.5+aa,d));
+#elif defined(TEXTURE)
   outColor = inColor*texture(texSampler,inUV);
 #else
   outColor = inColor;
@@ -0,0 +1,19 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec4 inColor;
+layout(location = 1) in vec4 inEdge;
+layout(location = 2) in vec3 inRound;
+layout(location = 3) in flat float inSharp;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+  float d = min(min(inEdge.x,inEdge.y),min(inEdge.z,inEdge.w));
+  if(inRound.z>0.0)
+    d = min(d,inRound.z-length(inRound.xy));
+  float a = inColor.a*clamp(d*inSharp+0.5,0.0,1.0);
+  if(a<=0.0)
+    discard;
+  outColor = vec4(inColor.rgb,a);
+  }
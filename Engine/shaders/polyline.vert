@@ -0,0 +1,207 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+out gl_PerVertex {
+  vec4 gl_Position;
+  };
+
+// xy - device pixels, z - RGBA8 color bits, w - width (0 - break between polylines)
+layout(std430, binding = 0) readonly buffer Points {
+  vec4 pt[];
+  };
+
+layout(push_constant, std140) uniform UboPush {
+  vec2  invSize; // 2/w, 2/h
+  uint  begin;
+  uint  count;
+  uint  join;    // Pen::JoinStyle
+  uint  cap;     // Pen::CapStyle
+  uint  aa;
+  } push;
+
+layout(location = 0) out vec4 outColor;
+layout(location = 1) out vec4 outEdge;   // distances to edges, linear over triangle
+layout(location = 2) out vec3 outRound;  // offset from round join/cap center and radius, 0 - none
+layout(location = 3) flat out float outSharp;
+
+const uint  MiterJoin  = 0u;
+const uint  RoundJoin  = 2u;
+const uint  SquareCap  = 1u;
+const uint  RoundCap   = 2u;
+const float MiterLimit = 4.0;
+const float Far        = 1e6;
+
+// one instance per segment: body (two halves), patch at the end (join or cap), patch at the beginning (cap)
+const uint BodyVert  = 12u;
+const uint PatchVert = 9u;
+const uint fan[9]    = {0u,1u,2u, 0u,2u,3u, 0u,3u,4u};
+
+vec2 hw   = vec2(0); // half width, half width with AA fringe
+vec2 posV = vec2(0);
+vec4 edge = vec4(Far);
+vec3 rnd  = vec3(0);
+
+vec2 tangent(vec2 a, vec2 b) {
+  vec2 d = b-a;
+  return d/length(d);
+  }
+
+// Bodies of two segments would overlap at the inner side of a joint, blending translucent pens twice.
+// Instead, inner corners of both bodies are moved to the intersection of their inner edges, so bodies
+// meet at a shared edge. Evaluated identically by both segments, to keep the seam watertight; not done
+// for very sharp turns, where the cut would reach past the middle of a segment.
+bool innerCorner(vec2 a, vec2 at, vec2 b, vec2 side, out vec2 x) {
+  vec2  t0 = tangent(a,at);
+  vec2  t1 = tangent(at,b);
+  vec2  n0 = vec2(-t0.y,t0.x);
+  vec2  n1 = vec2(-t1.y,t1.x);
+  float cr = t0.x*t1.y - t0.y*t1.x;
+  float c  = dot(t0,t1);
+  if(cr<0.0) {
+    n0 = -n0;
+    n1 = -n1;
+    }
+  x = at;
+  if(dot(side,n0+n1)<=0.0 || length(t0+t1)<1e-4)
+    return false;
+  // cut spans hw*tan(angle/2) along the segment, neighbour must cover hw*sin(angle) past the joint
+  float s = hw.y*abs(cr);
+  if(max(s/(1.0+c),s) > 0.5*min(length(at-a),length(b-at)))
+    return false;
+  x = at + (n0+n1)*(hw.y/(1.0+c));
+  return true;
+  }
+
+// fan around center: c, a, x1, x2, b
+void patch(uint id, vec2 c, vec2 a, vec2 x1, vec2 x2, vec2 b) {
+  vec2 p[5] = {c, a, x1, x2, b};
+  posV = p[fan[id]];
+  }
+
+void capPatch(uint id, vec2 at, vec2 t, vec2 n) {
+  vec2 a = at + n*hw.y;
+  vec2 b = at - n*hw.y;
+  patch(id, at, a, a+t*hw.y, b+t*hw.y, b);
+  rnd = vec3(posV-at, hw.x);
+  }
+
+void joinPatch(uint id, vec2 at, vec2 t0, vec2 t1) {
+  float cr = t0.x*t1.y - t0.y*t1.x;
+  if(abs(cr)<1e-4 && dot(t0,t1)>0.0) {
+    posV = at;
+    return;
+    }
+  // outer side of the turn
+  float sgn = cr>0.0 ? -1.0 : 1.0;
+  vec2  n0  = sgn*vec2(-t0.y,t0.x);
+  vec2  n1  = sgn*vec2(-t1.y,t1.x);
+  vec2  m   = n0+n1;
+  m = length(m)>1e-4 ? normalize(m) : t0;
+
+  vec2  a   = at + n0*hw.y;
+  vec2  b   = at + n1*hw.y;
+  float ml  = 1.0/max(dot(m,n0),1e-4);
+  if(push.join==MiterJoin && ml<=MiterLimit) {
+    vec2 x = at + m*hw.y*ml;
+    patch(id, at, a, x, x, b);
+    } else {
+    // polygon, that circumscribes arc from a to b
+    float k = hw.y*tan(acos(clamp(dot(n0,n1),-1.0,1.0))*0.25);
+    patch(id, at, a, a+t0*k, b-t1*k, b);
+    }
+
+  vec2 d = posV-at;
+  if(push.join==RoundJoin) {
+    rnd = vec3(d, hw.x);
+    return;
+    }
+  edge.x = hw.x - dot(d,n0);
+  edge.y = hw.x - dot(d,n1);
+  if(push.join!=MiterJoin || ml>MiterLimit)
+    edge.z = hw.x*dot(m,n0) - dot(d,m);
+  }
+
+void main() {
+  uint  seg = uint(gl_InstanceIndex);
+  uint  vid = uint(gl_VertexIndex);
+  uint  i   = push.begin + seg;
+
+  vec4  p1  = pt[i];
+  vec4  p2  = pt[i+1];
+  vec4  p0  = seg>0u           ? pt[i-1] : vec4(0);
+  vec4  p3  = seg+2u<push.count ? pt[i+2] : vec4(0);
+
+  vec2  dir = p2.xy-p1.xy;
+  float len = length(dir);
+
+  outColor  = unpackUnorm4x8(floatBitsToUint(p1.z));
+  outSharp  = push.aa!=0u ? 1.0 : 1e4;
+  if(p1.w<=0.0 || p2.w<=0.0 || len<=0.0) {
+    outEdge     = vec4(0);
+    outRound    = vec3(0);
+    gl_Position = vec4(-2,-2,0,1);
+    return;
+    }
+
+  float fringe = push.aa!=0u ? 1.0 : 0.0;
+  float width = p1.w;
+  if(push.aa!=0u && width<1.0) {
+    // thin lines fade instead of getting thinner
+    outColor.a *= width;
+    width       = 1.0;
+    }
+  hw = vec2(width*0.5, width*0.5+fringe);
+
+  vec2  t   = tangent(p1.xy,p2.xy);
+  vec2  n   = vec2(-t.y,t.x);
+  bool  beg = p0.w<=0.0;
+  bool  end = p3.w<=0.0;
+
+  if(vid<BodyVert) {
+    // square cap extends body, flat and square caps are anti-aliased by end distance
+    float sq0 = (beg && push.cap==SquareCap) ? hw.x : 0.0;
+    float sq1 = (end && push.cap==SquareCap) ? hw.x : 0.0;
+    float e0  = (beg && push.cap!=RoundCap)  ? sq0+fringe : 0.0;
+    float e1  = (end && push.cap!=RoundCap)  ? sq1+fringe : 0.0;
+
+    // halves of the body on each side of center line, x - end, y - side (0 is on center line)
+    const vec2 body[12] = vec2[](vec2(0,0),vec2(0,-1),vec2(1,-1), vec2(0,0),vec2(1,-1),vec2(1,0),
+                                 vec2(0,0),vec2(1, 1),vec2(0, 1), vec2(0,0),vec2(1, 0),vec2(1,1));
+    vec2 q = body[vid];
+    // end vertices are computed from p2, the same way as join patch, to keep the seam watertight
+    posV = q.x>0.0 ? p2.xy + t*e1 : p1.xy - t*e0;
+    if(q.y!=0.0) {
+      vec2 x;
+      bool inner = q.x>0.0 ? (!end && innerCorner(p1.xy,p2.xy,p3.xy,n*q.y,x)) :
+                             (!beg && innerCorner(p0.xy,p1.xy,p2.xy,n*q.y,x));
+      posV = inner ? x : posV + n*(q.y*hw.y);
+      }
+
+    float along  = dot(posV-p1.xy,t);
+    float across = dot(posV-p1.xy,n);
+    edge.x = hw.x + across;
+    edge.y = hw.x - across;
+    if(beg && push.cap!=RoundCap)
+      edge.z = along + sq0;
+    if(end && push.cap!=RoundCap)
+      edge.w = len + sq1 - along;
+    }
+  else if(vid<BodyVert+PatchVert) {
+    uint id = vid-BodyVert;
+    if(!end)
+      joinPatch(id, p2.xy, t, tangent(p2.xy,p3.xy)); else
+    if(push.cap==RoundCap)
+      capPatch(id, p2.xy, t, n); else
+      posV = p2.xy;
+    }
+  else {
+    uint id = vid-BodyVert-PatchVert;
+    if(beg && push.cap==RoundCap)
+      capPatch(id, p1.xy, -t, -n); else
+      posV = p1.xy;
+    }
+
+  outEdge     = edge;
+  outRound    = rnd;
+  gl_Position = vec4(posV*push.invSize-vec2(1.0), 0.0, 1.0);
+  }
@@ -34,10 +34,10 @@ struct Application::Impl : SystemApi::AppCallBack {
     auto italic  = AppFonts::get("Roboto-Italic.ttf");
     auto bItalic = AppFonts::get("Roboto-BoldItalic.ttf");
 
-    fontDef = Font(FontElement(regular.data, regular.len),
-                   FontElement(bold.data, bold.len),
-                   FontElement(italic.data, italic.len),
-                   FontElement(bItalic.data, bItalic.len));
+    fontDef = Font(FontElement::fromStaticData(regular.data, regular.len),
+                   FontElement::fromStaticData(bold.data, bold.len),
+                   FontElement::fromStaticData(italic.data, italic.len),
+                   FontElement::fromStaticData(bItalic.data, bItalic.len));
     return fontDef;
     }
 
@@ -0,0 +1,164 @@
+#include <Tempest/RasterImage>
+#include <Tempest/TextureAtlas>
+#include <Tempest/Sprite>
+#include <Tempest/Event>
+#include <Tempest/Painter>
+#include <Tempest/Except>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+#include <cstring>
+
+using namespace Tempest;
+
+namespace {
+
+struct Rgba {
+  uint8_t r=0,g=0,b=0,a=0;
+  };
+
+Rgba at(const RasterImage& img, int x, int y) {
+  auto p = reinterpret_cast<const uint8_t*>(img.pixmap().data()) + (size_t(y)*img.w()+size_t(x))*4;
+  return Rgba{p[0],p[1],p[2],p[3]};
+  }
+
+size_t count(const RasterImage& img, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+  size_t n = 0;
+  for(int y=0; y<int(img.h()); ++y)
+    for(int x=0; x<int(img.w()); ++x) {
+      auto p = at(img,x,y);
+      if(p.r==r && p.g==g && p.b==b && p.a==a)
+        ++n;
+      }
+  return n;
+  }
+
+}
+
+#define EXPECT_RGBA(img,x,y,R,G,B,A) { \
+  auto px = at(img,x,y); \
+  EXPECT_NEAR(px.r,R,1); EXPECT_NEAR(px.g,G,1); EXPECT_NEAR(px.b,B,1); EXPECT_NEAR(px.a,A,1); \
+  }
+
+TEST(RasterImage, Fill) {
+  TextureAtlas atlas;
+  RasterImage  img;
+  {
+  PaintEvent e(img,atlas,64,64);
+  Painter    p(e);
+  p.setBrush(Brush(Color(1,0,0,1),Painter::NoBlend));
+  p.drawRect(8,8,16,16);
+  }
+  // top-left rule: rect of two triangles covers exactly its pixels, without gaps or double coverage
+  EXPECT_EQ(count(img,255,0,0,255),16u*16u);
+  EXPECT_RGBA(img, 8, 8,255,0,0,255);
+  EXPECT_RGBA(img,23,23,255,0,0,255);
+  EXPECT_RGBA(img, 7, 8,  0,0,0,  0);
+  EXPECT_RGBA(img,24,23,  0,0,0,  0);
+  }
+
+TEST(RasterImage, Blend) {
+  TextureAtlas atlas;
+  RasterImage  img;
+  {
+  PaintEvent e(img,atlas,32,32);
+  Painter    p(e);
+  p.setBrush(Brush(Color(0,0,1,1),Painter::NoBlend));
+  p.drawRect(0,0,32,32);
+  p.setBrush(Brush(Color(1,0,0,0.5f),Painter::Alpha));
+  p.drawRect(0,0,16,32);
+  p.setBrush(Brush(Color(0,0.5f,0,0),Painter::Add));
+  p.drawRect(16,0,16,32);
+  }
+  EXPECT_RGBA(img, 4,4,128,  0,128,191);
+  EXPECT_RGBA(img,20,4,  0,128,255,255);
+  }
+
+TEST(RasterImage, Scissor) {
+  TextureAtlas atlas;
+  RasterImage  img;
+  {
+  PaintEvent e(img,atlas,64,64);
+  Painter    p(e);
+  p.setBrush(Brush(Color(0,1,0,1),Painter::NoBlend));
+  p.setScissor(4,4,16,8);
+  p.drawRect(0,0,64,64);
+  }
+  EXPECT_EQ(count(img,0,255,0,255),16u*8u);
+  EXPECT_RGBA(img, 4, 4,0,255,0,255);
+  EXPECT_RGBA(img,19,11,0,255,0,255);
+  EXPECT_RGBA(img,20,11,0,  0,0,  0);
+  EXPECT_RGBA(img,19,12,0,  0,0,  0);
+  }
+
+TEST(RasterImage, Stroke) {
+  TextureAtlas atlas;
+  RasterImage  img;
+  {
+  PaintEvent e(img,atlas,64,64);
+  Painter    p(e);
+  p.setPen(Pen(Color(1,1,1,1),Painter::NoBlend,4));
+  p.drawLine(8,32,56,32);
+  }
+  // opaque core on the line, nothing far from it
+  EXPECT_RGBA(img,32,31,255,255,255,255);
+  EXPECT_RGBA(img,32,32,255,255,255,255);
+  for(int x=0; x<64; ++x) {
+    EXPECT_EQ(at(img,x,20).a,0) << x;
+    EXPECT_EQ(at(img,x,44).a,0) << x;
+    }
+  for(int y=0; y<64; ++y) {
+    EXPECT_EQ(at(img, 2,y).a,0) << y;
+    EXPECT_EQ(at(img,62,y).a,0) << y;
+    }
+  }
+
+TEST(RasterImage, Sprite) {
+  TextureAtlas atlas;
+  RasterImage  img;
+
+  Pixmap pm(4,4,TextureFormat::RGBA8);
+  auto   src = reinterpret_cast<uint8_t*>(pm.data());
+  for(size_t i=0; i<4*4; ++i) {
+    src[i*4+0] = uint8_t(i*16);
+    src[i*4+1] = uint8_t(255-i*16);
+    src[i*4+2] = uint8_t(i*5);
+    src[i*4+3] = 255;
+    }
+  // padding sprite: texture is not at the page origin
+  Sprite pad = atlas.load(Pixmap(5,3,TextureFormat::RGBA8));
+  Sprite spr = atlas.load(pm);
+  {
+  PaintEvent e(img,atlas,16,16);
+  Painter    p(e);
+  p.setBrush(Brush(spr,Painter::NoBlend));
+  p.drawRect(2,2,4,4, 0,0,4,4);
+  }
+  // 1:1 mapping samples texel centers
+  for(int y=0; y<4; ++y)
+    for(int x=0; x<4; ++x) {
+      const uint8_t* s = src+size_t(y*4+x)*4;
+      EXPECT_RGBA(img,2+x,2+y,s[0],s[1],s[2],s[3]);
+      }
+  EXPECT_RGBA(img,1,1,0,0,0,0);
+  EXPECT_RGBA(img,6,6,0,0,0,0);
+  }
+
+TEST(RasterImage, Threads) {
+  TextureAtlas atlas;
+  RasterImage  img[2];
+  for(int i=0; i<2; ++i) {
+    img[i].setThreadCount(i==0 ? 1 : 4);
+    PaintEvent e(img[i],atlas,300,200);
+    Painter    p(e);
+    for(int r=0; r<20; ++r) {
+      p.setBrush(Brush(Color(float(r)/20.f,0.5f,1.f-float(r)/20.f,0.5f),Painter::Alpha));
+      p.drawRect(r*13,r*7,90,60);
+      }
+    p.setPen(Pen(Color(1,1,1,1),Painter::Alpha,2));
+    p.drawLine(0,0,299,199);
+    }
+  ASSERT_EQ(img[0].pixmap().dataSize(),img[1].pixmap().dataSize());
+  EXPECT_EQ(std::memcmp(img[0].pixmap().data(),img[1].pixmap().data(),img[0].pixmap().dataSize()),0);
+  }
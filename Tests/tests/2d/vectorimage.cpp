@@ -0,0 +1,146 @@
+#include <Tempest/VulkanApi>
+#include <Tempest/MetalApi>
+
+#include <Tempest/Except>
+#include <Tempest/Device>
+#include <Tempest/Log>
+#include <Tempest/VectorImage>
+#include <Tempest/TextureAtlas>
+#include <Tempest/Event>
+#include <Tempest/Painter>
+#include <Tempest/MemReader>
+#include <Tempest/MemWriter>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+#include <cstring>
+
+using namespace Tempest;
+
+namespace {
+
+#if defined(__OSX__)
+using TestApi = MetalApi;
+#else
+using TestApi = VulkanApi;
+#endif
+
+template<class Fn>
+void withDevice(Fn fn) {
+  try {
+    TestApi api{ApiFlags::Validation};
+    Device  device(api);
+    fn(device);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+void paint(VectorImage& img, TextureAtlas& atlas, bool sprite) {
+  PaintEvent e(img,atlas,320,240);
+  Painter    p(e,Painter::Clear);
+
+  p.setBrush(Brush(Color(1,0,0,1),Painter::NoBlend));
+  p.drawRect(10,10,100,50);
+  if(sprite) {
+    Pixmap pm(8,8,TextureFormat::RGBA8);
+    auto   px = reinterpret_cast<uint8_t*>(pm.data());
+    for(size_t i=0; i<8*8*4; ++i)
+      px[i] = uint8_t(i);
+    p.setBrush(Brush(atlas.load(pm),Painter::Alpha));
+    p.drawRect(200,10,64,64,0,0,8,8);
+    }
+  p.setPen(Pen(Color(1,1,1,1),Painter::Alpha,3));
+  p.drawLine(0,230,319,200);
+  }
+
+std::vector<uint8_t> save(const VectorImage& img, bool compress) {
+  std::vector<uint8_t> ret;
+  MemWriter            w(ret);
+  img.save(w,compress);
+  return ret;
+  }
+
+void load(const std::vector<uint8_t>& data, TextureAtlas& atlas) {
+  VectorImage img;
+  MemReader   r(data);
+  img.load(r,atlas);
+  }
+
+template<class T>
+void patch(std::vector<uint8_t>& data, size_t at, T val) {
+  std::memcpy(data.data()+at,&val,sizeof(val));
+  }
+
+}
+
+TEST(VectorImage, SaveLoad) {
+  withDevice([](Device& device){
+    TextureAtlas atlas(device);
+    VectorImage  img;
+    paint(img,atlas,true);
+
+    for(bool compress:{false,true}) {
+      // saved sprite is cropped by its uv's with a texel border, so placement in empty atlas gives the same crop
+      TextureAtlas dest(device);
+      auto         a = save(img,compress);
+      VectorImage  img2;
+      MemReader    r(a);
+      img2.load(r,dest);
+      EXPECT_EQ(img2.w(),img.w());
+      EXPECT_EQ(img2.h(),img.h());
+      // sprites are placed into atlas again, display list must be the same
+      EXPECT_EQ(save(img2,compress),a) << "compress=" << compress;
+      }
+    });
+  }
+
+TEST(VectorImage, LoadMalformed) {
+  withDevice([](Device& device){
+    TextureAtlas atlas(device);
+    VectorImage  img;
+    paint(img,atlas,false);
+
+    // magic, version, flags, w, h, [raw size], payload size
+    const size_t payload   = 4*5+8;
+    const size_t blockSize = 4+sizeof(Rect)+3+4+8+8;
+    const auto   src       = save(img,false);
+    uint32_t     blocks    = 0;
+    std::memcpy(&blocks,src.data()+payload,sizeof(blocks));
+
+    auto truncated = src;
+    truncated.resize(src.size()-8);
+    EXPECT_THROW(load(truncated,atlas),std::system_error);
+
+    auto blockCount = src;
+    patch(blockCount,payload,uint32_t(-1));
+    EXPECT_THROW(load(blockCount,atlas),std::system_error);
+
+    auto topology = src;
+    patch(topology,payload+4,uint8_t(7));
+    EXPECT_THROW(load(topology,atlas),std::system_error);
+
+    auto blend = src;
+    patch(blend,payload+4+1,uint8_t(200));
+    EXPECT_THROW(load(blend,atlas),std::system_error);
+
+    // no sprites: sprite count, then count of points
+    auto points = src;
+    patch(points,payload+4+blocks*blockSize+4,uint64_t(1)<<60);
+    EXPECT_THROW(load(points,atlas),std::system_error);
+
+    auto range = src;
+    patch(range,payload+4+blockSize-8,uint64_t(-1));
+    EXPECT_THROW(load(range,atlas),std::system_error);
+
+    auto rawSize = save(img,true);
+    patch(rawSize,4*5,uint64_t(1)<<50);
+    EXPECT_THROW(load(rawSize,atlas),std::system_error);
+
+    EXPECT_NO_THROW(load(src,atlas));
+    });
+  }
@@ -1,8 +1,14 @@
 #include "../gapi/deviceallocator.h"
+#include "utils/testrandom.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
 
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
 using namespace testing;
 using namespace Tempest::Detail;
 
@@ -18,6 +24,12 @@ struct TestDevice {
     }
   };
 
+struct CountingDevice : TestDevice {
+  DeviceMemory alloc(size_t size, uint32_t typeId) { ++live; return TestDevice::alloc(size,typeId); }
+  void free(DeviceMemory m, size_t size, uint32_t typeId) { --live; TestDevice::free(m,size,typeId); }
+  int live = 0;
+  };
+
 TEST(main, DeviceAllocator) {
   TestDevice device;
   DeviceAllocator<TestDevice> memory(device);
@@ -91,3 +103,157 @@ TEST(main, DeviceAllocatorAlign1) {
   memory.free(p1);
   memory.free(p3);
   }
+
+TEST(main, DeviceAllocatorReuse) {
+  TestDevice device;
+  DeviceAllocator<TestDevice> memory(device);
+  using Allocation = DeviceAllocator<TestDevice>::Allocation;
+
+  // freed neighbours are merged back, so whole page is usable again
+  std::vector<Allocation> a;
+  for(size_t i=0; i<64; ++i)
+    a.push_back(memory.alloc(1024*1024, 256,0,0, false));
+  auto keep = memory.alloc(1024*1024, 1,0,0, false);
+  for(size_t i=0; i<a.size(); i+=2)
+    memory.free(a[i]);
+  for(size_t i=1; i<a.size(); i+=2)
+    memory.free(a[i]);
+
+  auto big = memory.alloc(64*1024*1024, 256,0,0, false);
+  EXPECT_EQ(big.page,keep.page);
+  EXPECT_EQ(big.offset,0u);
+  memory.free(big);
+  memory.free(keep);
+  }
+
+TEST(main, DeviceAllocatorExactPage) {
+  CountingDevice device;
+  DeviceAllocator<CountingDevice> memory(device);
+
+  // pages of exactly requested size, that is not on size class boundary
+  auto d = memory.dedicatedAlloc(16777300, 256,0,0, false);
+  ASSERT_NE(d.page,nullptr);
+  EXPECT_EQ(d.offset,0u);
+  EXPECT_EQ(device.live,1);
+
+  auto big = memory.alloc(200*1024*1024, 256,0,0, false);
+  ASSERT_NE(big.page,nullptr);
+  EXPECT_EQ(big.offset,0u);
+  EXPECT_EQ(device.live,2);
+
+  // page, that can't hold the request, is not kept
+  auto bad = memory.dedicatedAlloc(0, 1,0,0, false);
+  EXPECT_EQ(bad.page,nullptr);
+  EXPECT_EQ(device.live,2);
+
+  memory.free(d);
+  memory.free(big);
+  EXPECT_EQ(device.live,0);
+  }
+
+TEST(main, DeviceAllocatorReleaseSmall) {
+  CountingDevice device;
+  DeviceAllocator<CountingDevice> memory(device);
+  using Allocation = DeviceAllocator<CountingDevice>::Allocation;
+
+  // small allocations are cached on free, but page is released with the last one
+  std::vector<Allocation> a;
+  for(size_t i=0; i<16; ++i)
+    a.push_back(memory.alloc(256, 16,0,0, false));
+  EXPECT_EQ(device.live,1);
+  for(auto& i:a)
+    memory.free(i);
+  EXPECT_EQ(device.live,0);
+
+  // page is still reused through cache, while it has live allocations
+  auto keep = memory.alloc(256, 16,0,0, false);
+  auto p1   = memory.alloc(256, 16,0,0, false);
+  memory.free(p1);
+  auto p2   = memory.alloc(256, 16,0,0, false);
+  EXPECT_EQ(p1.page,p2.page);
+  EXPECT_EQ(p1.offset,p2.offset);
+  memory.free(p2);
+  memory.free(keep);
+  EXPECT_EQ(device.live,0);
+  }
+
+TEST(main, DeviceAllocatorStress) {
+  TestDevice device;
+  DeviceAllocator<TestDevice> memory(device);
+  using Allocation = DeviceAllocator<TestDevice>::Allocation;
+
+  TestRandom rnd(7);
+  const size_t align[] = {1,4,16,256,4096};
+
+  std::vector<Allocation> live;
+  size_t                  ops = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for(size_t i=0; i<200000; ++i) {
+    if(live.size()<20000 && (live.empty() || rnd(3)!=0)) {
+      // mostly small buffers (uniforms, vertices), sometimes bigger ones
+      size_t sz = rnd(8)==0 ? 4096+rnd(256*1024) : 16+rnd(4096);
+      size_t al = align[rnd(5)];
+      live.push_back(memory.alloc(sz,al,0,0,false));
+      ASSERT_NE(live.back().page,nullptr);
+      ASSERT_EQ(live.back().offset%al,0u);
+      } else {
+      size_t id = rnd(uint32_t(live.size()));
+      memory.free(live[id]);
+      live[id] = live.back();
+      live.pop_back();
+      }
+    ++ops;
+    }
+  auto t1 = std::chrono::steady_clock::now();
+
+  std::sort(live.begin(),live.end(),[](const Allocation& a, const Allocation& b){
+    return a.page!=b.page ? a.page<b.page : a.offset<b.offset;
+    });
+  for(size_t i=1; i<live.size(); ++i) {
+    if(live[i].page==live[i-1].page) {
+      EXPECT_LE(live[i-1].offset+live[i-1].size,live[i].offset);
+      }
+    }
+
+  benchmarkLog("[ stress   ] %zu ops, %zu live, %.1f ns/op\n",ops,live.size(),
+              double(std::chrono::duration_cast<std::chrono::nanoseconds>(t1-t0).count())/double(ops));
+  for(auto& i:live)
+    memory.free(i);
+  }
+
+TEST(main, DeviceAllocatorThreads) {
+  // loader threads create and release small buffers concurrently
+  for(size_t threads:{1,2,4,8}) {
+    TestDevice device;
+    DeviceAllocator<TestDevice> memory(device);
+    using Allocation = DeviceAllocator<TestDevice>::Allocation;
+
+    const size_t             opsPerThread = 100000;
+    std::vector<std::thread> th;
+    auto t0 = std::chrono::steady_clock::now();
+    for(size_t t=0; t<threads; ++t) {
+      th.emplace_back([&memory,t](){
+        TestRandom rnd(uint32_t(t+1));
+        std::vector<Allocation> live;
+        for(size_t i=0; i<opsPerThread; ++i) {
+          if(live.size()<256 && (live.empty() || rnd(2)==0)) {
+            live.push_back(memory.alloc(64*(1+rnd(64)),256,uint32_t(t%2),0,false));
+            } else {
+            size_t id = rnd(uint32_t(live.size()));
+            memory.free(live[id]);
+            live[id] = live.back();
+            live.pop_back();
+            }
+          }
+        for(auto& i:live)
+          memory.free(i);
+        });
+      }
+    for(auto& i:th)
+      i.join();
+    auto t1 = std::chrono::steady_clock::now();
+
+    const double sec = double(std::chrono::duration_cast<std::chrono::microseconds>(t1-t0).count())/1e6;
+    benchmarkLog("[ threads  ] %zu: %.1f Mops/s\n",threads,double(threads*opsPerThread)/sec/1e6);
+    }
+  }
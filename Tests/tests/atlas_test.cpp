@@ -1,9 +1,16 @@
 #include "../gapi/deviceallocator.h"
 #include "../gapi/rectallocator.h"
+#include "utils/testrandom.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
 using namespace testing;
 using namespace Tempest::Detail;
 
@@ -65,3 +72,279 @@ TEST(main, AtlasBlockAlloator1) {
     b.free(st[i]);
     */
   }
+
+namespace {
+
+bool hasOverlap(const std::vector<Allocation>& a) {
+  for(size_t i=0; i<a.size(); ++i) {
+    if(a[i].node==nullptr)
+      continue;
+    auto ri = a[i].pageRect();
+    if(uint32_t(ri.x)+a[i].node->w>uint32_t(ri.w) || uint32_t(ri.y)+a[i].node->h>uint32_t(ri.h))
+      return true;
+    for(size_t r=i+1; r<a.size(); ++r) {
+      if(a[r].node==nullptr || a[r].pageId()!=a[i].pageId())
+        continue;
+      auto ni = a[i].node;
+      auto nr = a[r].node;
+      if(ni->x<nr->x+nr->w && nr->x<ni->x+ni->w && ni->y<nr->y+nr->h && nr->y<ni->y+ni->h)
+        return true;
+      }
+    }
+  return false;
+  }
+
+struct Occupancy {
+  size_t pages    = 0;
+  double fill     = 0;
+  double nsPerOp  = 0;
+  };
+
+Occupancy measure(Allocator::Policy policy, const std::vector<Tempest::Size>& sz) {
+  TestDevice             device;
+  Allocator              allocator(device,policy);
+  std::vector<Allocation> a;
+  a.reserve(sz.size());
+
+  auto t0 = std::chrono::steady_clock::now();
+  for(auto& i:sz)
+    a.push_back(allocator.alloc(uint32_t(i.w),uint32_t(i.h)));
+  auto t1 = std::chrono::steady_clock::now();
+
+  std::vector<void*> pages;
+  uint64_t           used = 0, total = 0;
+  for(auto& i:a) {
+    used += uint64_t(i.node->w)*i.node->h;
+    if(std::find(pages.begin(),pages.end(),i.pageId())!=pages.end())
+      continue;
+    pages.push_back(i.pageId());
+    total += uint64_t(i.pageRect().w)*uint64_t(i.pageRect().h);
+    }
+
+  Occupancy ret;
+  ret.pages   = pages.size();
+  ret.fill    = double(used)/double(total);
+  ret.nsPerOp = double(std::chrono::duration_cast<std::chrono::nanoseconds>(t1-t0).count())/double(sz.size());
+  return ret;
+  }
+
+const char* policyName(Allocator::Policy p) {
+  switch(p) {
+    case Allocator::Guillotine: return "guillotine";
+    case Allocator::Skyline:    return "skyline";
+    case Allocator::MaxRects:   return "maxrects";
+    }
+  return "";
+  }
+}
+
+TEST(main, AtlasAllocatorPolicy) {
+  for(auto policy:{Allocator::Guillotine,Allocator::Skyline,Allocator::MaxRects}) {
+    TestDevice              device;
+    Allocator               allocator(device,policy);
+    std::vector<Allocation> a;
+
+    for(auto& i:TestRandom::sizes(4,96,4,96,600))
+      a.push_back(allocator.alloc(uint32_t(i.w),uint32_t(i.h)));
+    EXPECT_FALSE(hasOverlap(a)) << policyName(policy);
+
+    for(size_t i=0; i<a.size(); i+=2)
+      a[i] = Allocation();
+    for(auto& i:TestRandom::sizes(4,64,4,64,600))
+      a.push_back(allocator.alloc(uint32_t(i.w),uint32_t(i.h)));
+    EXPECT_FALSE(hasOverlap(a)) << policyName(policy);
+
+    // whole page, and reuse of emptied pages
+    a.push_back(allocator.alloc(512,512));
+    a.clear();
+    auto s = allocator.alloc(512,512);
+    EXPECT_EQ(s.pos(),Tempest::Point(0,0)) << policyName(policy);
+    }
+  }
+
+TEST(main, AtlasAllocatorOccupancy) {
+  struct Set {
+    const char* name;
+    uint32_t    w0,w1,h0,h1;
+    size_t      count;
+    };
+  // glyphs of text sizes 12..32px and mixed ui icons
+  const Set sets[] = {
+    {"glyphs", 4,24, 10,32,  8000},
+    {"icons",  16,96,16,96,  1500},
+    };
+
+  for(auto& s:sets) {
+    auto      sz    = TestRandom::sizes(s.w0,s.w1,s.h0,s.h1,s.count);
+    Occupancy guill = measure(Allocator::Guillotine,sz);
+    for(auto policy:{Allocator::Guillotine,Allocator::Skyline,Allocator::MaxRects}) {
+      Occupancy o = measure(policy,sz);
+      benchmarkLog("[ %-8s ] %-10s pages: %3zu, occupancy: %5.1f%%, %7.1f ns/alloc\n",
+                  s.name,policyName(policy),o.pages,o.fill*100.0,o.nsPerOp);
+      EXPECT_LE(o.pages,guill.pages);
+      }
+    }
+  }
+
+TEST(main, AtlasAllocatorThreads) {
+  // nodes are allocated and released from different threads, with thread caches in between
+  for(auto policy:{Allocator::Guillotine,Allocator::Skyline,Allocator::MaxRects}) {
+    TestDevice              device;
+    Allocator               allocator(device,policy);
+    std::vector<Allocation> shared[4];
+
+    for(size_t pass=0; pass<4; ++pass) {
+      std::vector<std::thread> th;
+      for(size_t t=0; t<4; ++t) {
+        // each pass releases allocations made by another thread on previous pass
+        th.emplace_back([&allocator,&a=shared[(t+pass)%4]](){
+          a.clear();
+          for(auto& i:TestRandom::sizes(2,16,2,16,500))
+            a.push_back(allocator.alloc(uint32_t(i.w),uint32_t(i.h)));
+          });
+        }
+      for(auto& i:th)
+        i.join();
+      }
+
+    std::vector<Allocation> all;
+    for(auto& s:shared)
+      all.insert(all.end(),s.begin(),s.end());
+    EXPECT_FALSE(hasOverlap(all)) << policyName(policy);
+    }
+  }
+
+TEST(main, AtlasAllocatorCompact) {
+  for(auto policy:{Allocator::Skyline,Allocator::MaxRects}) {
+    TestDevice              device;
+    Allocator               allocator(device,policy);
+    std::vector<Allocation> a;
+
+    for(auto& i:TestRandom::sizes(8,48,8,48,3000))
+      a.push_back(allocator.alloc(uint32_t(i.w),uint32_t(i.h)));
+
+    // keep every 5-th allocation alive, so all pages become sparse
+    std::vector<Allocation> live;
+    for(size_t i=0; i<a.size(); i+=5)
+      live.push_back(a[i]);
+    a.clear();
+
+    // shared allocation must stay in place
+    Allocation pinned = live.back();
+    auto       pos    = pinned.pos();
+    auto       page   = pinned.pageId();
+
+    std::vector<void*> before;
+    for(auto& i:live)
+      if(std::find(before.begin(),before.end(),i.pageId())==before.end())
+        before.push_back(i.pageId());
+
+    size_t moved    = 0;
+    size_t released = allocator.compact([&](void*,const Tempest::Rect&,void*,uint32_t,uint32_t){ ++moved; });
+
+    std::vector<void*> after;
+    for(auto& i:live)
+      if(std::find(after.begin(),after.end(),i.pageId())==after.end())
+        after.push_back(i.pageId());
+
+    EXPECT_GT(moved,0u)                            << policyName(policy);
+    EXPECT_EQ(released,before.size()-after.size()) << policyName(policy);
+    EXPECT_LT(after.size(),before.size())          << policyName(policy);
+    EXPECT_FALSE(hasOverlap(live))                 << policyName(policy);
+    EXPECT_EQ(pinned.pos(),pos)                    << policyName(policy);
+    EXPECT_EQ(pinned.pageId(),page)                << policyName(policy);
+    }
+  }
+
+TEST(main, AtlasAllocatorCompactPageSize) {
+  TestDevice              device;
+  Allocator               allocator(device,Allocator::MaxRects);
+  std::vector<Allocation> a;
+
+  for(auto& i:TestRandom::sizes(8,48,8,48,2000))
+    a.push_back(allocator.alloc(uint32_t(i.w),uint32_t(i.h)));
+
+  // bigger pages: existing ones are merged into a single page
+  allocator.setPageSize(2048);
+  allocator.compact([](void*,const Tempest::Rect&,void*,uint32_t,uint32_t){});
+
+  for(auto& i:a) {
+    EXPECT_EQ(i.pageId(),a[0].pageId());
+    EXPECT_EQ(i.pageRect().w,2048);
+    }
+  EXPECT_FALSE(hasOverlap(a));
+  }
+
+TEST(main, AtlasAllocatorCompactPinned) {
+  // small pages, that can't be evacuated, must not make compact() allocate merge page
+  struct CountingDevice : TestDevice {
+    size_t allocated = 0;
+    DeviceMemory alloc(uint32_t w,uint32_t h){
+      ++allocated;
+      return TestDevice::alloc(w,h);
+      }
+    };
+  using Counting = Tempest::RectAllocator<CountingDevice>;
+
+  CountingDevice                    device;
+  Counting                          allocator(device,Counting::MaxRects);
+  std::vector<Counting::Allocation> a, pin;
+
+  for(auto& i:TestRandom::sizes(8,48,8,48,2000))
+    a.push_back(allocator.alloc(uint32_t(i.w),uint32_t(i.h)));
+  pin = a;
+
+  const size_t pages = device.allocated;
+  ASSERT_GT(pages,1u);
+
+  allocator.setPageSize(2048);
+  for(int i=0; i<3; ++i) {
+    size_t released = allocator.compact([](void*,const Tempest::Rect&,void*,uint32_t,uint32_t){});
+    EXPECT_EQ(released,0u);
+    }
+  EXPECT_EQ(device.allocated,pages);
+  EXPECT_EQ(a[0].pageRect().w,512);
+  }
+
+TEST(main, AtlasAllocatorCompactFill) {
+  // allocations are filled under allocator lock, concurrent compact() must never move half-written content
+  TestDevice              device;
+  Allocator               allocator(device,Allocator::MaxRects);
+  const uint32_t          pw = allocator.pageSize();
+  std::vector<Allocation> live;
+  std::atomic<bool>       done{false};
+
+  auto move = [pw](void* src,const Tempest::Rect& r,void* dst,uint32_t x,uint32_t y) {
+    for(int i=0; i<r.h; ++i)
+      std::memcpy(reinterpret_cast<uint8_t*>(dst)+(y+uint32_t(i))*pw+x,
+                  reinterpret_cast<uint8_t*>(src)+uint32_t(r.y+i)*pw+uint32_t(r.x),size_t(r.w));
+    };
+
+  std::thread compact([&](){
+    while(!done.load())
+      allocator.compact(move);
+    });
+
+  auto sz = TestRandom::sizes(8,48,8,48,2000);
+  for(size_t i=0; i<sz.size(); ++i) {
+    const uint8_t tag = uint8_t(i%251+1);
+    auto a = allocator.alloc(uint32_t(sz[i].w),uint32_t(sz[i].h),[&](void*& m,const Tempest::Point& p){
+      for(int y=0; y<sz[i].h; ++y)
+        std::memset(reinterpret_cast<uint8_t*>(m)+uint32_t(p.y+y)*pw+uint32_t(p.x),tag,size_t(sz[i].w));
+      });
+    // keep every 5-th allocation, so pages become sparse and get compacted
+    if(i%5==0)
+      live.push_back(std::move(a));
+    }
+  done.store(true);
+  compact.join();
+  allocator.compact(move);
+
+  for(size_t i=0; i<live.size(); ++i) {
+    const uint8_t tag = uint8_t((i*5)%251+1);
+    auto          p   = live[i].pos();
+    auto          m   = reinterpret_cast<const uint8_t*>(live[i].memory());
+    EXPECT_EQ(m[uint32_t(p.y)*pw+uint32_t(p.x)],tag);
+    }
+  EXPECT_FALSE(hasOverlap(live));
+  }
@@ -0,0 +1,157 @@
+#include <Tempest/Font>
+#include <Tempest/TextureAtlas>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+#include <vector>
+
+#include "builtin_fonts.h"
+
+using namespace testing;
+using namespace Tempest;
+
+namespace {
+
+struct Key {
+  char32_t ch   = 0;
+  float    size = 0;
+  };
+
+// enough keys for several rehashes of glyph table
+std::vector<Key> keys() {
+  std::vector<Key> k;
+  for(int sz=8; sz<32; ++sz)
+    for(char32_t ch='A'; ch<='Z'; ++ch)
+      k.push_back(Key{ch,float(sz)});
+  return k;
+  }
+
+FontElement roboto() {
+  auto fnt = AppFonts::get("Roboto-Regular.ttf");
+  return FontElement::fromStaticData(fnt.data,fnt.len);
+  }
+
+void expectSame(const FontElement::Letter& a, const FontElement::Letter& b) {
+  EXPECT_EQ(a.size,          b.size);
+  EXPECT_EQ(a.dpos,          b.dpos);
+  EXPECT_EQ(a.advance,       b.advance);
+  EXPECT_EQ(a.hasView,       b.hasView);
+  EXPECT_EQ(a.distanceField, b.distanceField);
+  }
+
+}
+
+TEST(main,FontCacheRehash) {
+  TextureAtlas atlas;
+  FontElement  fnt = roboto();
+  FontElement  ref = roboto();
+  const auto   key = keys();
+
+  std::vector<const FontElement::Letter*> lt;
+  for(auto& k:key)
+    lt.push_back(&fnt.distanceFieldLetter(k.ch,k.size,atlas));
+
+  auto st = fnt.cacheStats();
+  EXPECT_EQ(st.glyphs,   key.size());
+  EXPECT_EQ(st.misses,   key.size());
+  EXPECT_EQ(st.hits,     0u);
+  EXPECT_EQ(st.evictions,0u);
+
+  // letters don't move, when table grows
+  for(size_t i=0; i<key.size(); ++i) {
+    auto& l = fnt.distanceFieldLetter(key[i].ch,key[i].size,atlas);
+    EXPECT_EQ(&l,lt[i]);
+    expectSame(l,ref.distanceFieldLetter(key[i].ch,key[i].size,atlas));
+    }
+
+  st = fnt.cacheStats();
+  EXPECT_EQ(st.glyphs,key.size());
+  EXPECT_EQ(st.misses,key.size());
+  EXPECT_EQ(st.hits,  key.size());
+  }
+
+TEST(main,FontCacheEviction) {
+  TextureAtlas  atlas;
+  FontElement   fnt    = roboto();
+  FontElement   ref    = roboto();
+  const auto    key    = keys();
+  const size_t  budget = 100;
+
+  for(auto& k:key)
+    fnt.distanceFieldLetter(k.ch,k.size,atlas);
+
+  // least recently used glyphs go first: the last 'budget' keys stay
+  fnt.setGlyphBudget(budget);
+  auto st = fnt.cacheStats();
+  EXPECT_EQ(st.glyphs,   budget);
+  EXPECT_EQ(st.evictions,key.size()-budget);
+
+  for(size_t i=key.size()-budget; i<key.size(); ++i)
+    expectSame(fnt.distanceFieldLetter(key[i].ch,key[i].size,atlas),ref.distanceFieldLetter(key[i].ch,key[i].size,atlas));
+
+  st = fnt.cacheStats();
+  EXPECT_EQ(st.glyphs,   budget);
+  EXPECT_EQ(st.hits,     budget);
+  EXPECT_EQ(st.misses,   key.size());
+  EXPECT_EQ(st.evictions,key.size()-budget);
+  }
+
+TEST(main,FontCacheReinsert) {
+  TextureAtlas  atlas;
+  FontElement   fnt    = roboto();
+  FontElement   ref    = roboto();
+  const auto    key    = keys();
+  const size_t  budget = 100;
+  const size_t  back   = 50;
+
+  for(auto& k:key)
+    fnt.distanceFieldLetter(k.ch,k.size,atlas);
+  fnt.setGlyphBudget(budget);
+  const size_t memory = fnt.cacheStats().memory;
+
+  // evicted glyphs come back into freed entries, so table doesn't grow
+  for(size_t i=0; i<back; ++i)
+    expectSame(fnt.distanceFieldLetter(key[i].ch,key[i].size,atlas),ref.distanceFieldLetter(key[i].ch,key[i].size,atlas));
+  fnt.setGlyphBudget(budget);
+
+  auto st = fnt.cacheStats();
+  EXPECT_EQ(st.glyphs,   budget);
+  EXPECT_EQ(st.hits,     0u);
+  EXPECT_EQ(st.misses,   key.size()+back);
+  EXPECT_EQ(st.evictions,key.size()-budget+back);
+  EXPECT_EQ(st.memory,   memory);
+
+  // reinserted ones are the most recent: all of them are still found, along with the newest of the rest
+  for(size_t i=0; i<back; ++i)
+    expectSame(fnt.distanceFieldLetter(key[i].ch,key[i].size,atlas),ref.distanceFieldLetter(key[i].ch,key[i].size,atlas));
+  for(size_t i=key.size()-(budget-back); i<key.size(); ++i)
+    expectSame(fnt.distanceFieldLetter(key[i].ch,key[i].size,atlas),ref.distanceFieldLetter(key[i].ch,key[i].size,atlas));
+
+  st = fnt.cacheStats();
+  EXPECT_EQ(st.glyphs,budget);
+  EXPECT_EQ(st.hits,  budget);
+  EXPECT_EQ(st.misses,key.size()+back);
+  }
+
+TEST(main,FontCacheSubpixel) {
+  // subpixel variants live in the same table as regular letters
+  TextureAtlas  atlas;
+  FontElement   fnt    = roboto();
+  FontElement   ref    = roboto();
+  const auto    key    = keys();
+  const size_t  budget = 100;
+
+  fnt.setGlyphBudget(budget);
+  for(int pass=0; pass<2; ++pass) {
+    for(auto& k:key)
+      expectSame(fnt.letter(k.ch,k.size,1,atlas),ref.letter(k.ch,k.size,1,atlas));
+    }
+  fnt.setGlyphBudget(budget);
+
+  auto st = fnt.cacheStats();
+  EXPECT_EQ(st.glyphs,   budget);
+  EXPECT_EQ(st.hits,     0u);
+  EXPECT_EQ(st.misses,   2*key.size());
+  EXPECT_EQ(st.evictions,2*key.size()-budget);
+  }
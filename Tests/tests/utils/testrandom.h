@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Tempest/Point>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Deterministic LCG for allocator tests: same sequence on every platform, unlike std::rand
+class TestRandom {
+  public:
+    explicit TestRandom(uint32_t seed):seed(seed){}
+
+    // uniform in [0,n)
+    uint32_t operator()(uint32_t n) {
+      seed = seed*1664525u + 1013904223u;
+      return (seed>>8)%n;
+      }
+
+    // uniform in [a,b]
+    uint32_t range(uint32_t a, uint32_t b) {
+      return a + (*this)(b-a+1);
+      }
+
+    // 'count' sizes with width in [w0,w1] and height in [h0,h1]
+    static std::vector<Tempest::Size> sizes(uint32_t w0, uint32_t w1, uint32_t h0, uint32_t h1, size_t count) {
+      TestRandom                 rnd(12345);
+      std::vector<Tempest::Size> ret(count);
+      for(auto& i:ret) {
+        const int w = int(rnd.range(w0,w1));
+        i = Tempest::Size(w,int(rnd.range(h0,h1)));
+        }
+      return ret;
+      }
+
+  private:
+    uint32_t seed = 0;
+  };
+
+// Timing printouts are only for manual runs: TEMPEST_TEST_BENCHMARK=1
+inline bool isBenchmarkRun() {
+  static const bool ret = std::getenv("TEMPEST_TEST_BENCHMARK")!=nullptr;
+  return ret;
+  }
+
+template<class ... Args>
+void benchmarkLog(const char* fmt, Args... args) {
+  if(isBenchmarkRun())
+    std::printf(fmt,args...);
+  }
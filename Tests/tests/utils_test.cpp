@@ -1,8 +1,11 @@
 #include <Tempest/Point>
+#include <Tempest/Transform>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
 
+#include <vector>
+
 using namespace testing;
 using namespace Tempest;
 
@@ -21,3 +24,34 @@ TEST(main, Point) {
   EXPECT_EQ(div,b);
   EXPECT_EQ(neg,(Point{-3,-4}));
   }
+
+TEST(main, TransformMapN) {
+  // vectorized mapN must match scalar map, odd count covers the scalar tail
+  Transform scale(2,0,0, 0,3,0, 5,-7,1);
+  Transform rot  = scale;
+  rot.rotate(30);
+  Transform proj(1,0,0.01f, 0,1,0.02f, 0,0,1);
+
+  EXPECT_EQ(scale.type(),Transform::T_AxisAligned);
+  EXPECT_EQ(rot.type(),  Transform::T_Affine);
+  EXPECT_EQ(proj.type(), Transform::T_None);
+
+  for(auto& tr:{scale,rot,proj}) {
+    for(size_t n:{0,1,2,3,7,8}) {
+      std::vector<float> xy(n*2), out(n*2);
+      for(size_t i=0; i<xy.size(); ++i)
+        xy[i] = float(i)*1.5f-4.f;
+      tr.mapN(xy.data(),out.data(),n);
+      for(size_t i=0; i<n; ++i) {
+        float x = 0, y = 0;
+        tr.map(xy[i*2],xy[i*2+1],x,y);
+        EXPECT_FLOAT_EQ(out[i*2+0],x) << "n=" << n << " i=" << i;
+        EXPECT_FLOAT_EQ(out[i*2+1],y) << "n=" << n << " i=" << i;
+        }
+
+      // in-place
+      tr.mapN(xy.data(),xy.data(),n);
+      EXPECT_EQ(xy,out);
+      }
+    }
+  }